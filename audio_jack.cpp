@@ -3,6 +3,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <sys/time.h>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <math.h>
@@ -10,7 +11,10 @@
 #include <jack/jack.h>
 #include "audio_jack.h"
 #include "track_manager.h"
-#include "input_gpio.h"
+#include "group_manager.h"
+#include "rt_log.h"
+#include "latency_histogram.h"
+#include "block_pool.h"
 
 // Deal with static variable requirements
 jack_port_t* AudioJack::input_port1 = nullptr;
@@ -21,13 +25,26 @@ jack_client_t* AudioJack::client = nullptr;
 
 
 AudioJack::AudioJack() {
+  pv_.track_manager_left_ = nullptr;
+  pv_.track_manager_right_ = nullptr;
+  pv_.group_manager_ = nullptr;
+  pv_.group_manager_right_ = nullptr;
+  pv_.last_track = MAX_TRACK_COUNT;
   pv_.enabled = false;
+  pv_.zero_copy = false;
+  pv_.sample_rate = 0;
+  pv_.telemetry = nullptr;
+  memset(&pv_.telemetry_data, 0, sizeof(pv_.telemetry_data));
+  pv_.telemetry_frames = 0;
+  pv_.telemetry_busy_ns = 0;
+  pv_.telemetry_period_ns = 0;
 }
 
 AudioJack::~AudioJack() {
   pv_.track_manager_left_ = nullptr;
   pv_.track_manager_right_ = nullptr;
-  pv_.gpio_ = nullptr;
+  pv_.group_manager_ = nullptr;
+  pv_.group_manager_right_ = nullptr;
 }
 
 void AudioJack::SignalHandler(int sig) {
@@ -41,13 +58,133 @@ void AudioJack::SetTrackManagerPtr(TrackManager* tm_left, TrackManager* tm_right
   pv_.track_manager_right_ = tm_right;
 }
 
-void AudioJack::SetInputGpioPtr(InputGpio* gpio) {
-  pv_.gpio_ = gpio;
+void AudioJack::SetGroupManagerPtr(GroupManager* gm_left, GroupManager* gm_right) {
+  pv_.group_manager_ = gm_left;
+  pv_.group_manager_right_ = gm_right;
+}
+
+bool AudioJack::PushCommand(const ControlCommand &command) {
+  return pv_.commands.Push(command);
+}
+
+uint32_t AudioJack::GetLateCommands() {
+  return pv_.commands.GetLateCommands();
+}
+
+DspLoadMonitor& AudioJack::GetDspLoad() {
+  return pv_.dsp_load;
+}
+
+// Called by JACK from its own thread, the audio thread picks it up next cycle
+int AudioJack::JackXrun(void *arg) {
+  ProcessVars *pv = (ProcessVars*)arg;
+  pv->dsp_load.AddXrun();
+  return 0;
 }
 
 int AudioJack::Process(jack_nframes_t nframes, void *arg) {
-  jack_default_audio_sample_t *in1, *in2, *out1, *out2;
   ProcessVars *pv = (ProcessVars*)arg;
+  uint64_t period_start_ns = MonotonicNowNs();
+  ProcessPeriod(pv, nframes, period_start_ns);
+  if (pv->sample_rate == 0) { return 0; }
+  uint64_t cycle_ns = MonotonicNowNs() - period_start_ns;
+  uint64_t period_ns = (uint64_t)nframes * 1000000000ULL / pv->sample_rate;
+  RecordCycle(pv, nframes, period_start_ns, cycle_ns, period_ns);
+  if (pv->telemetry != nullptr) {
+    PublishTelemetry(pv, nframes, period_start_ns, cycle_ns, period_ns);
+  }
+  return 0;
+}
+
+// Times the cycle against its period, the engine state is only read when the
+// cycle overran or an xrun was reported
+void AudioJack::RecordCycle(ProcessVars *pv, jack_nframes_t nframes, uint64_t period_start_ns,
+                            uint64_t cycle_ns, uint64_t period_ns) {
+  OverrunCause cause;
+  if (!pv->dsp_load.AddCycle(cycle_ns, period_ns, cause)) { return; }
+
+  OverrunRecord record = {};
+  record.cause = cause;
+  record.timestamp_ns = period_start_ns;
+  record.cycle_ns = cycle_ns;
+  record.period_ns = period_ns;
+  record.nframes = nframes;
+  record.last_track = pv->last_track;
+  record.active_group = pv->group_manager_ != nullptr ? pv->group_manager_->GetActiveGroup() : 0;
+  TrackManager *tm = pv->track_manager_left_;
+  if (tm != nullptr) {
+    uint16_t off = tm->GetTracksOff();
+    record.tracks_playing = tm->GetTracksInPlayback();
+    record.tracks_muted = tm->GetTracksInMute();
+    record.tracks_recording = ~(off | record.tracks_playing | record.tracks_muted) & 0xFFFF;
+    record.master_index = tm->GetMasterCurrentIndex();
+    record.master_end_index = tm->GetMasterEndIndex();
+  }
+  pv->dsp_load.AddOverrun(record);
+}
+
+static inline float Peak(const jack_default_audio_sample_t *samples, uint32_t nframes, float peak) {
+  for (uint32_t i = 0; i < nframes; i++) {
+    peak = std::max(peak, fabsf(samples[i]));
+  }
+  return peak;
+}
+
+void AudioJack::UpdatePeaks(ProcessVars *pv, jack_default_audio_sample_t *in1,
+                            jack_default_audio_sample_t *in2, jack_default_audio_sample_t *out1,
+                            jack_default_audio_sample_t *out2, uint32_t nframes) {
+  TelemetryData &data = pv->telemetry_data;
+  data.input_peak[0] = Peak(in1, nframes, data.input_peak[0]);
+  data.input_peak[1] = Peak(in2, nframes, data.input_peak[1]);
+  data.output_peak[0] = Peak(out1, nframes, data.output_peak[0]);
+  data.output_peak[1] = Peak(out2, nframes, data.output_peak[1]);
+}
+
+// Fills in the engine state and copies it out at about TELEMETRY_RATE_HZ,
+// every other cycle only adds its load
+void AudioJack::PublishTelemetry(ProcessVars *pv, jack_nframes_t nframes, uint64_t period_start_ns,
+                                 uint64_t cycle_ns, uint64_t period_ns) {
+  pv->telemetry_frames += nframes;
+  pv->telemetry_busy_ns += cycle_ns;
+  pv->telemetry_period_ns += period_ns;
+  if (pv->telemetry_frames < pv->sample_rate / TELEMETRY_RATE_HZ) { return; }
+
+  TelemetryData &data = pv->telemetry_data;
+  data.timestamp_ns = period_start_ns;
+  data.frame = pv->commands.GetCurrentFrame();
+  data.sample_rate = pv->sample_rate;
+  data.last_track = pv->last_track;
+  data.active_group = pv->group_manager_ != nullptr ? pv->group_manager_->GetActiveGroup() : 0;
+  TrackManager *tm = pv->track_manager_left_;
+  if (tm != nullptr) {
+    data.master_current_index = tm->GetMasterCurrentIndex();
+    data.master_end_index = tm->GetMasterEndIndex();
+    for (uint32_t t = 0; t < MAX_TRACK_COUNT; t++) {
+      data.track_state[t] = (uint8_t)tm->GetTrackState(t);
+    }
+  }
+  data.dsp_load_permille = pv->telemetry_busy_ns * 1000 / pv->telemetry_period_ns;
+  data.worst_load_permille = pv->dsp_load.GetWorstLoadPermille();
+  data.xruns = pv->dsp_load.GetXruns();
+  data.late_cycles = pv->dsp_load.GetLateCycles();
+  data.command_queue_depth = pv->commands.GetQueueDepth();
+  data.overrun_queue_depth = pv->dsp_load.GetQueuedOverruns();
+  data.pool_pages_in_use = BlockPool::getInstance().GetPagesInUse();
+  data.pool_page_count = BlockPool::getInstance().GetPageCount();
+  pv->telemetry->Publish(data);
+
+  // Peaks and load start again for the next publish
+  for (uint32_t channel = 0; channel < 2; channel++) {
+    data.input_peak[channel] = 0.0f;
+    data.output_peak[channel] = 0.0f;
+  }
+  pv->telemetry_frames = 0;
+  pv->telemetry_busy_ns = 0;
+  pv->telemetry_period_ns = 0;
+}
+
+void AudioJack::ProcessPeriod(ProcessVars *pv, jack_nframes_t nframes, uint64_t period_start_ns) {
+  jack_default_audio_sample_t *in1, *in2, *out1, *out2;
 
   in1 = (jack_default_audio_sample_t*)jack_port_get_buffer (input_port1, nframes);
   in2 = (jack_default_audio_sample_t*)jack_port_get_buffer (input_port2, nframes);
@@ -55,42 +192,76 @@ int AudioJack::Process(jack_nframes_t nframes, void *arg) {
   out1 = (jack_default_audio_sample_t*)jack_port_get_buffer (output_port1, nframes);
   out2 = (jack_default_audio_sample_t*)jack_port_get_buffer (output_port2, nframes);
 
-  if (!pv->enabled) { return 0;}
-  if (pv->gpio_ == nullptr) {
+  if (!pv->enabled) {
+    memset(out1, 0, sizeof(jack_default_audio_sample_t) * nframes);
+    memset(out2, 0, sizeof(jack_default_audio_sample_t) * nframes);
+    return;
+  }
+  pv->commands.StartPeriod(period_start_ns);
+  if (pv->group_manager_ == nullptr) {
 #ifdef JACK_VERBOSE
-    std::cout << "InputGpio Ptr is null!" << std::endl;
+    RT_LOG("GroupManager Ptr is null!");
 #endif
-    return 0;
+    memset(out1, 0, sizeof(jack_default_audio_sample_t) * nframes);
+    memset(out2, 0, sizeof(jack_default_audio_sample_t) * nframes);
+    pv->commands.Advance(nframes);
+    return;
+  }
+
+  // State changes from the control thread happen here, at the frame each
+  // command is scheduled for. The period is only split where a command is due
+  uint32_t done = 0;
+  while (done < nframes) {
+    ControlCommand command;
+    while (pv->commands.PopDue(command)) {
+      if (pv->track_manager_left_ != nullptr) {
+        DispatchControlCommand(command, *pv->track_manager_left_, *pv->group_manager_);
+      }
+      if (pv->track_manager_right_ != nullptr && pv->group_manager_right_ != nullptr) {
+        DispatchControlCommand(command, *pv->track_manager_right_, *pv->group_manager_right_);
+      }
+      if (command.for_track) {
+        pv->last_track = command.track;
+      }
+    }
+    uint32_t chunk = pv->commands.FramesToNextCommand(nframes - done);
+    ProcessChunk(pv, in1 + done, in2 + done, out1 + done, out2 + done, chunk);
+    pv->commands.Advance(chunk);
+    done += chunk;
+  }
+  if (pv->telemetry != nullptr) {
+    UpdatePeaks(pv, in1, in2, out1, out2, nframes);
   }
-  if (pv->gpio_->GetLastTrack() >= MAX_TRACK_COUNT) { return 0; }
+}
 
+void AudioJack::ProcessChunk(ProcessVars *pv, jack_default_audio_sample_t *in1,
+                             jack_default_audio_sample_t *in2, jack_default_audio_sample_t *out1,
+                             jack_default_audio_sample_t *out2, uint32_t nframes) {
+  // Channels with nothing to play are zeroed, with zero copy the port
+  // buffers still hold an earlier period
+  bool no_track = pv->last_track >= MAX_TRACK_COUNT;
   if (pv->track_manager_left_ == nullptr) {
 #ifdef JACK_VERBOSE
-    std::cout << "TrackManagerPtr Left is null!" << std::endl;
+    RT_LOG("TrackManagerPtr Left is null!");
 #endif
-    return 0;
+    memset(out1, 0, sizeof(jack_default_audio_sample_t) * nframes);
+  } else if (no_track || pv->track_manager_left_->GetTracksOff() == 0xFFFF) {
+    memset(out1, 0, sizeof(jack_default_audio_sample_t) * nframes);
   } else {
-    if (pv->track_manager_left_->GetTracksOff() == 0xFFFF) { return 0; }
-    pv->track_manager_left_->CopyToInputBuffer(in1, SAMPLES_PER_BLOCK);
-    pv->track_manager_left_->StateProcess(pv->gpio_->GetLastTrack()); // copies buffer to track, performs mixdown and updates indicies
-    pv->track_manager_left_->CopyMixdownToBuffer(out1, nframes);
-    if (pv->track_manager_right_ == nullptr) {
-      pv->track_manager_left_->CopyMixdownToBuffer(out2, nframes);
-    }
+    // copies buffer to track, performs mixdown and updates indicies
+    // JACK's period may be shorter or longer than SAMPLES_PER_BLOCK
+    pv->track_manager_left_->ProcessFrames(pv->last_track, in1, out1, nframes, pv->zero_copy);
   }
-  if (pv->track_manager_right_ == nullptr) {
+  if (pv->track_manager_right_ == nullptr || pv->group_manager_right_ == nullptr) {
 #ifdef JACK_VERBOSE
-    std::cout << "TrackManagerPtr Right is null!" << std::endl;
+    RT_LOG("TrackManagerPtr Right is null!");
 #endif
-    return 0;
+    memcpy(out2, out1, sizeof(jack_default_audio_sample_t) * nframes);
+  } else if (no_track || pv->track_manager_right_->GetTracksOff() == 0xFFFF) {
+    memset(out2, 0, sizeof(jack_default_audio_sample_t) * nframes);
   } else {
-    if (pv->track_manager_right_->GetTracksOff() == 0xFFFF) { return 0; } 
-    pv->track_manager_right_->CopyToInputBuffer(in2, SAMPLES_PER_BLOCK);
-    pv->track_manager_right_->StateProcess(pv->gpio_->GetLastTrack()); // copies buffer to track, performs mixdown and updates indicies
-    pv->track_manager_right_->CopyMixdownToBuffer(out2, nframes);
+    pv->track_manager_right_->ProcessFrames(pv->last_track, in2, out2, nframes, pv->zero_copy);
   }
-
-  return 0;      
 }
 
 
@@ -102,6 +273,15 @@ void AudioJack::EnableJackAudioProcessing() {
   pv_.enabled = true;
 }
 
+// Set before enabling processing
+void AudioJack::SetZeroCopyIO(bool enable) {
+  pv_.zero_copy = enable;
+}
+
+void AudioJack::SetTelemetryWriter(TelemetryWriter *writer) {
+  pv_.telemetry = writer;
+}
+
 // This is taken almost verbatim from simple_client.c
 int AudioJack::Init(int argc, char *argv[]) {
   const char **ports;
@@ -150,6 +330,11 @@ int AudioJack::Init(int argc, char *argv[]) {
   */
 
   jack_set_process_callback (client, Process, &pv_);
+  pv_.sample_rate = jack_get_sample_rate(client);
+  pv_.commands.SetSampleRate(pv_.sample_rate);
+
+  // Counted by the audio thread's DspLoadMonitor, see GetDspLoad
+  jack_set_xrun_callback (client, JackXrun, &pv_);
 
   /* tell the JACK server to call `jack_shutdown()' if
      it ever shuts down, either entirely, or if it
@@ -3,10 +3,13 @@
 
 #include <jack/jack.h>
 #include "track_manager.h"
-#include "input_gpio.h"
+#include "group_manager.h"
+#include "control_command.h"
+#include "dsp_load.h"
+#include "telemetry.h"
 
 class TrackManager;
-class InputGpio;
+class GroupManager;
 
 class AudioJack {
 
@@ -20,14 +23,45 @@ class AudioJack {
   typedef struct {
     TrackManager* track_manager_left_;
     TrackManager* track_manager_right_;
-    InputGpio* gpio_;
+    GroupManager* group_manager_;
+    // Each channel's TrackManager is driven by its own GroupManager, the
+    // right channel only runs with both set
+    GroupManager* group_manager_right_;
+    // Filled by the control thread, applied by Process at each command's block
+    CommandScheduler commands;
+    // Track of the last track command, owned by the audio thread
+    uint32_t last_track;
     bool enabled;
+    // Record from and mix into the JACK port buffers directly
+    bool zero_copy;
+    // Cycle times against the period and the xruns JACK reports
+    DspLoadMonitor dsp_load;
+    uint32_t sample_rate;
+    // Published every sample_rate / TELEMETRY_RATE_HZ frames, nullptr is off.
+    // Load and peaks are gathered here between publishes
+    TelemetryWriter *telemetry;
+    TelemetryData telemetry_data;
+    uint32_t telemetry_frames;
+    uint64_t telemetry_busy_ns;
+    uint64_t telemetry_period_ns;
   } ProcessVars;
   ProcessVars pv_;
 
   static void SignalHandler(int sig);
   static void JackShutdown(void *arg);
+  static int JackXrun(void *arg);
   static int Process(jack_nframes_t nframes, void *arg);
+  static void ProcessPeriod(ProcessVars *pv, jack_nframes_t nframes, uint64_t period_start_ns);
+  static void RecordCycle(ProcessVars *pv, jack_nframes_t nframes, uint64_t period_start_ns,
+                          uint64_t cycle_ns, uint64_t period_ns);
+  static void UpdatePeaks(ProcessVars *pv, jack_default_audio_sample_t *in1,
+                          jack_default_audio_sample_t *in2, jack_default_audio_sample_t *out1,
+                          jack_default_audio_sample_t *out2, uint32_t nframes);
+  static void PublishTelemetry(ProcessVars *pv, jack_nframes_t nframes, uint64_t period_start_ns,
+                               uint64_t cycle_ns, uint64_t period_ns);
+  static void ProcessChunk(ProcessVars *pv, jack_default_audio_sample_t *in1,
+                           jack_default_audio_sample_t *in2, jack_default_audio_sample_t *out1,
+                           jack_default_audio_sample_t *out2, uint32_t nframes);
 
   public:
   AudioJack();
@@ -35,9 +69,20 @@ class AudioJack {
 
   int Init(int argc, char *argv[]);
   void SetTrackManagerPtr(TrackManager* tm_left, TrackManager* tm_right);
-  void SetInputGpioPtr(InputGpio* gpio);
+  // Every command goes to both channels, the right TrackManager needs its own
+  // GroupManager so group state changes are applied once per channel
+  void SetGroupManagerPtr(GroupManager* gm_left, GroupManager* gm_right = nullptr);
+  // Control thread only, false if the queue is full and the command was dropped
+  // Commands with a timestamp are applied at the block CommandScheduler picks
+  bool PushCommand(const ControlCommand &command);
+  uint32_t GetLateCommands();
+  // Read from any thread, overrun records from one thread only
+  DspLoadMonitor& GetDspLoad();
 
   void EnableJackAudioProcessing();
+  void SetZeroCopyIO(bool enable);
+  // Set before enabling processing, nullptr stops publishing
+  void SetTelemetryWriter(TelemetryWriter *writer);
 };
 
 #endif // AUDIO_JACK_H
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "track_manager.h"
+#include "track_manager_states.h"
+#include "mix_parameters.h"
+#include "mixer.h"
+
+// ns per block for the engine's hot paths - the mixer kernels, the mixdown at
+// 0-16 audible tracks, index updates, record/overdub copies and a block of
+// StateProcess in each TrackManagerState.
+// Each benchmark runs BENCH_BLOCKS blocks BENCH_REPEATS times, the median and
+// fastest repeat are reported. -o writes the results as CSV
+//
+// bench_engine [-o results.csv]
+// The default build has no optimisation, configure with
+// -DCMAKE_BUILD_TYPE=Release for figures close to the Pi's
+
+#define BENCH_BLOCKS 2048
+#define BENCH_REPEATS 5
+#define BENCH_WARMUP_BLOCKS 256
+// Length of the loop the background tracks play
+#define BENCH_LOOP_BLOCKS 256
+// Tracks playing while the state benchmarks drive track 0
+#define BENCH_BACKGROUND_TRACKS 4
+
+typedef std::chrono::steady_clock Clock;
+
+#ifdef __OPTIMIZE__
+static const char *kBuild = "optimized";
+#else
+static const char *kBuild = "unoptimized";
+#endif
+
+struct BenchResult {
+  std::string name;
+  uint32_t param;
+  std::string kernel;
+  double median_ns;
+  double min_ns;
+};
+
+static std::vector<BenchResult> results;
+
+template <typename F>
+static void Measure(const std::string &name, uint32_t param, F block) {
+  for (uint32_t i = 0; i < BENCH_WARMUP_BLOCKS; i++) {
+    block(i);
+  }
+  std::array<double, BENCH_REPEATS> ns;
+  for (uint32_t r = 0; r < BENCH_REPEATS; r++) {
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < BENCH_BLOCKS; i++) {
+      block(i);
+    }
+    ns[r] = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / BENCH_BLOCKS;
+  }
+  std::sort(ns.begin(), ns.end());
+  BenchResult result = {name, param, MixerGetKernelName(MixerGetKernel()), ns[BENCH_REPEATS / 2], ns[0]};
+  results.push_back(result);
+  std::cout << name << "[" << param << "]," << result.kernel << ": " << result.median_ns
+            << " ns/block (min " << result.min_ns << ")" << std::endl;
+}
+
+// Tracks below count play a loop of BENCH_LOOP_BLOCKS from the start of the
+// master loop, the rest are off
+static void SetPlaybackTracks(TrackManager &tm, uint32_t count) {
+  for (uint32_t t = 0; t < MAX_TRACK_COUNT; t++) {
+    Track &track = tm.tracks.at(t);
+    if (t >= count) {
+      if (!track.IsTrackOff()) {
+        track.SetTrackToOff();
+      }
+      continue;
+    }
+    if (track.GetEndIndex() != BENCH_LOOP_BLOCKS - 1) {
+      for (uint32_t b = 0; b < BENCH_LOOP_BLOCKS; b++) {
+        track.SetBlockDataToSameValue(b, 0.01f * (t + 1));
+      }
+      track.SetStartIndex(0);
+      track.SetEndIndex(BENCH_LOOP_BLOCKS - 1);
+    }
+    track.SetCurrentIndex(0);
+    if (!track.IsTrackInPlayback()) {
+      track.SetTrackToInPlayback();
+    }
+  }
+  tm.SetMasterEndIndex(BENCH_LOOP_BLOCKS - 1);
+  tm.SetMasterCurrentIndex(0);
+}
+
+static void BenchMixer() {
+  DataBlock block1(0.25f), block2(-0.5f), mix_down;
+  Measure("mix_blocks", 2, [&](uint32_t i) { MixBlocks(block1, block2, mix_down); });
+}
+
+// Master position steps through the loop so sources stream from memory as
+// they do while playing
+static void BenchMixdown(TrackManager &tm, const char *name) {
+  for (uint32_t count = 0; count <= MAX_TRACK_COUNT; count++) {
+    SetPlaybackTracks(tm, count);
+    Measure(name, count, [&](uint32_t i) {
+      tm.SetMasterCurrentIndex(i % BENCH_LOOP_BLOCKS);
+      tm.PerformMixdown();
+    });
+  }
+}
+
+static void BenchIndexUpdate(TrackManager &tm) {
+  for (uint32_t count : {1, MAX_TRACK_COUNT}) {
+    SetPlaybackTracks(tm, count);
+    Measure("index_update_no_change", count, [&](uint32_t i) { tm.IndexUpdateAllStatesNoChange(); });
+  }
+}
+
+static void BenchCopyToTrack(TrackManager &tm) {
+  SetPlaybackTracks(tm, 0);
+  Track &track = tm.tracks.at(0);
+  for (bool overdub : {false, true}) {
+    if (overdub) {
+      track.SetTrackToOverdubbing();
+    } else {
+      track.SetTrackToInRecord();
+    }
+    Measure(overdub ? "copy_to_track_overdub" : "copy_to_track_record", 1, [&](uint32_t i) {
+      track.SetCurrentIndex(i % BENCH_LOOP_BLOCKS);
+      tm.CopyBufferToTrack(0);
+    });
+  }
+  track.SetTrackToOff();
+}
+
+// Track 0 is taken through each state with the button events while the
+// background tracks play, as on stage. Recording moves the master past the
+// background loop, so the record and overdub figures mix silence
+static void BenchStateProcess(TrackManager &tm) {
+  struct Step {
+    const char *name;
+    void (TrackManager::*event)(uint32_t);
+  };
+  const Step steps[] = {
+    {"state_process_off", nullptr},
+    {"state_process_record", &TrackManager::HandleDownEvent},
+    {"state_process_play", &TrackManager::HandleDownEvent},
+    {"state_process_overdub", &TrackManager::HandleDownEvent},
+    {"state_process_mute", &TrackManager::HandleDoubleDownEvent},
+    {"state_process_repeat", &TrackManager::HandleLongPulseEvent},
+  };
+  std::array<float, SAMPLES_PER_BLOCK> input;
+  std::array<float, SAMPLES_PER_BLOCK> output;
+  input.fill(0.1f);
+  SetPlaybackTracks(tm, BENCH_BACKGROUND_TRACKS + 1);
+  tm.tracks.at(0).SetTrackToOff();
+  for (const Step &step : steps) {
+    if (step.event != nullptr) {
+      (tm.*step.event)(0);
+    }
+    Measure(step.name, BENCH_BACKGROUND_TRACKS, [&](uint32_t i) {
+      tm.StateProcess(0, input.data(), output.data());
+    });
+  }
+  tm.HandleDoubleDownEvent(0);
+}
+
+int main(int argc, char *argv[]) {
+  const char *output_path = nullptr;
+  if (argc == 3 && std::string(argv[1]) == "-o") {
+    output_path = argv[2];
+  } else if (argc != 1) {
+    std::cerr << "usage: bench_engine [-o results.csv]" << std::endl;
+    return 1;
+  }
+  std::cout << "** bench_engine.cpp **" << std::endl;
+  std::cout << "build: " << kBuild << std::endl;
+
+  MixerInit();
+  MixKernelType best = MixerGetKernel();
+  TrackManager *tm = new TrackManager();
+
+  for (uint32_t k = 0; k < static_cast<uint32_t>(MixKernelType::kCount); k++) {
+    if (!MixerSelectKernel(static_cast<MixKernelType>(k))) {
+      continue;
+    }
+    BenchMixer();
+    BenchMixdown(*tm, "perform_mixdown");
+  }
+  MixerSelectKernel(best);
+
+  // Gains away from unity take the MixSourcesGain path
+  MixParameters mix_parameters;
+  for (uint32_t t = 0; t < MAX_TRACK_COUNT; t++) {
+    mix_parameters.SetTrackGain(t, 0.5f);
+  }
+  tm->SetMixParameters(&mix_parameters);
+  BenchMixdown(*tm, "perform_mixdown_gain");
+  tm->SetMixParameters(nullptr);
+
+  BenchIndexUpdate(*tm);
+  BenchCopyToTrack(*tm);
+  BenchStateProcess(*tm);
+  delete tm;
+
+  if (output_path != nullptr) {
+    std::ofstream file(output_path);
+    file << "benchmark,param,kernel,median_ns_per_block,min_ns_per_block,blocks,repeats,build" << std::endl;
+    for (const BenchResult &result : results) {
+      file << result.name << "," << result.param << "," << result.kernel << "," << result.median_ns << ","
+           << result.min_ns << "," << BENCH_BLOCKS << "," << BENCH_REPEATS << "," << kBuild << std::endl;
+    }
+    if (!file) {
+      std::cerr << "error: can't write " << output_path << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
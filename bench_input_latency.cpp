@@ -0,0 +1,73 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <thread>
+#include "input_gpio.h"
+#include "latency_histogram.h"
+
+// Press-to-command latency of the control loop, from the ISR timestamp to the
+// point gpio_main pushes the command, with presses injected from another
+// thread the way the wiringPi ISR threads queue them.
+// poll_1ms is the old loop, sleep 1ms then poll, wait is WaitForEvents.
+// Also counts loop wakeups while idle
+
+#define BENCH_PRESS_COUNT 400
+#define BENCH_IDLE_MS 500
+
+// Down and up on pin 0 every 2-6ms, timestamps taken as the ISR would
+static void InjectPresses(InputGpio *gi) {
+  std::mt19937 rng(1234);
+  std::uniform_int_distribution<int> gap_us(2000, 6000);
+  for (int i = 0; i < BENCH_PRESS_COUNT; i++) {
+    std::this_thread::sleep_for(std::chrono::microseconds(gap_us(rng)));
+    gi->InjectEvent(i % 2 ? InputProcessedEvent::kUp : InputProcessedEvent::kDown, 0, MonotonicNowNs());
+  }
+}
+
+static void RunLoop(InputGpio *gi, bool wait, LatencyHistogram &latency) {
+  uint32_t handled = 0;
+  while (handled < BENCH_PRESS_COUNT) {
+    if (wait) {
+      gi->WaitForEvents(100);
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    while (gi->ProcessAndHandleInputEvents()) {
+      latency.Add(MonotonicNowNs() - gi->GetLastEventTime());
+      handled++;
+    }
+  }
+}
+
+static uint32_t CountIdleWakeups(InputGpio *gi, bool wait) {
+  uint32_t wakeups = 0;
+  uint64_t end = MonotonicNowNs() + BENCH_IDLE_MS * 1000000ULL;
+  while (MonotonicNowNs() < end) {
+    if (wait) {
+      gi->WaitForEvents(BENCH_IDLE_MS);
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    gi->ProcessAndHandleInputEvents();
+    wakeups++;
+  }
+  return wakeups;
+}
+
+int main() {
+  std::cout << "** bench_input_latency.cpp **" << std::endl;
+  InputGpio gi;
+  for (bool wait : {false, true}) {
+    const char *name = wait ? "wait" : "poll_1ms";
+    LatencyHistogram latency;
+    gi.Reset();
+    std::thread presses(InjectPresses, &gi);
+    RunLoop(&gi, wait, latency);
+    presses.join();
+    latency.Print(name);
+    std::cout << name << "_idle_wakeups_per_s: "
+              << CountIdleWakeups(&gi, wait) * 1000 / BENCH_IDLE_MS << std::endl;
+  }
+  std::cout << "dropped_events: " << gi.GetDroppedEvents() << std::endl;
+  return 0;
+}
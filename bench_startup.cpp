@@ -0,0 +1,88 @@
+#include <iostream>
+#include <chrono>
+#include <sys/resource.h>
+#include "track_manager.h"
+#include "group_manager.h"
+#include "input_gpio.h"
+#include "output_i2c.h"
+#include "audio_jack.h"
+#include "memory_lock.h"
+
+// Time-to-ready for the objects the gpio target and the test targets build
+// before audio processing can start, plus the cost of the first write to each
+// track once recording starts
+
+typedef std::chrono::steady_clock Clock;
+
+static double ElapsedUs(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+static long MaxRssKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+int main() {
+  std::cout << "** bench_startup.cpp **" << std::endl;
+  std::cout << "rss_at_main_kb: " << MaxRssKb() << std::endl;
+
+  Clock::time_point start = Clock::now();
+  Clock::time_point stage = start;
+  MixerInit();
+  std::cout << "mixer_init_us: " << ElapsedUs(stage) << std::endl;
+
+  // Same objects as gpio_main.cpp, right channel as for stereo
+  stage = Clock::now();
+  InputGpio *gi = new InputGpio();
+  OutputI2C *oi = new OutputI2C();
+  TrackManager *tm_left = new TrackManager();
+  TrackManager *tm_right = new TrackManager();
+  GroupManager *gm = new GroupManager();
+  GroupManager *gm_right = new GroupManager();
+  AudioJack *jack = new AudioJack();
+  jack->SetTrackManagerPtr(tm_left, tm_right);
+  jack->SetGroupManagerPtr(gm, gm_right);
+  std::cout << "construct_gpio_objects_us: " << ElapsedUs(stage) << std::endl;
+  std::cout << "time_to_ready_us: " << ElapsedUs(start) << std::endl;
+  std::cout << "rss_ready_kb: " << MaxRssKb() << std::endl;
+
+  // Test targets build one TrackManager each
+  stage = Clock::now();
+  TrackManager *tm_test = new TrackManager();
+  std::cout << "construct_test_track_manager_us: " << ElapsedUs(stage) << std::endl;
+
+  // First touch of a fresh page happens inside the audio callback
+  float in[SAMPLES_PER_BLOCK] = {};
+  float out[SAMPLES_PER_BLOCK];
+  tm_left->HandleDownEvent(0);
+  stage = Clock::now();
+  tm_left->StateProcess(0, in, out);
+  std::cout << "first_record_block_us: " << ElapsedUs(stage) << std::endl;
+  stage = Clock::now();
+  tm_left->StateProcess(0, in, out);
+  std::cout << "second_record_block_us: " << ElapsedUs(stage) << std::endl;
+  std::cout << "rss_after_record_kb: " << MaxRssKb() << std::endl;
+
+  // Optional lock and pre-fault stage, then a record on a page never touched
+  stage = Clock::now();
+  MemoryLockReport lock = LockAudioMemory();
+  std::cout << "lock_memory_us: " << ElapsedUs(stage) << std::endl;
+  std::cout << "locked_kb: " << lock.bytes_locked / 1024 << std::endl;
+  std::cout << "prefaulted_kb: " << lock.bytes_prefaulted / 1024 << std::endl;
+  tm_left->HandleDownEvent(1);
+  stage = Clock::now();
+  tm_left->StateProcess(1, in, out);
+  std::cout << "first_record_block_prefaulted_us: " << ElapsedUs(stage) << std::endl;
+
+  delete tm_test;
+  delete jack;
+  delete gm;
+  delete gm_right;
+  delete tm_right;
+  delete tm_left;
+  delete oi;
+  delete gi;
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include <sys/mman.h>
+#include "block_pool.h"
+
+static const size_t kPoolBytes = (size_t)BLOCK_POOL_PAGE_COUNT * BLOCKS_PER_PAGE * sizeof(DataBlock);
+
+BlockPool::BlockPool() :
+  blocks_(nullptr),
+  page_count_(BLOCK_POOL_PAGE_COUNT),
+  next_(BLOCK_POOL_PAGE_COUNT),
+  dirty_(BLOCK_POOL_PAGE_COUNT, 0),
+  free_head_(0),
+  pages_in_use_(0),
+  failed_allocations_(0),
+  zero_block_(0.0f) {
+  // Zero bytes are 0.0f samples, so a fresh mapping is already a silent pool
+  void *mem = mmap(nullptr, kPoolBytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mem == MAP_FAILED) {
+    std::cout << "BlockPool: unable to map " << kPoolBytes << " bytes, tracks will not record" << std::endl;
+    page_count_ = 0;
+  } else {
+    blocks_ = static_cast<DataBlock*>(mem);
+  }
+
+  // Chain every page onto the free list, page 0 on top
+  for (uint32_t page = 0; page < page_count_; page++) {
+    next_[page] = page + 1 < page_count_ ? page + 1 : kNoPage;
+  }
+  free_head_.store(page_count_ > 0 ? 0 : kNoPage);
+}
+
+BlockPool::~BlockPool() {
+  if (blocks_ != nullptr) {
+    munmap(blocks_, kPoolBytes);
+  }
+}
+
+DataBlock* BlockPool::Allocate() {
+  uint64_t head = free_head_.load(std::memory_order_acquire);
+  uint32_t page;
+  for (;;) {
+    page = (uint32_t)head;
+    if (page == kNoPage) {
+      failed_allocations_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    uint64_t tag = (head >> 32) + 1;
+    uint64_t next = (tag << 32) | next_[page];
+    if (free_head_.compare_exchange_weak(head, next, std::memory_order_acquire,
+                                         std::memory_order_acquire)) {
+      break;
+    }
+  }
+  pages_in_use_.fetch_add(1, std::memory_order_relaxed);
+
+  DataBlock *blocks = &blocks_[page * BLOCKS_PER_PAGE];
+  if (dirty_[page]) {
+    for (uint32_t b = 0; b < BLOCKS_PER_PAGE; b++) {
+      blocks[b].samples_.fill(0.0f);
+    }
+    dirty_[page] = 0;
+  }
+  return blocks;
+}
+
+void BlockPool::Release(DataBlock *blocks) {
+  if (blocks == nullptr) { return; }
+  uint32_t page = (uint32_t)((blocks - blocks_) / BLOCKS_PER_PAGE);
+  dirty_[page] = 1;
+
+  uint64_t head = free_head_.load(std::memory_order_relaxed);
+  uint64_t next;
+  do {
+    next_[page] = (uint32_t)head;
+    next = (((head >> 32) + 1) << 32) | page;
+  } while (!free_head_.compare_exchange_weak(head, next, std::memory_order_release,
+                                             std::memory_order_relaxed));
+  pages_in_use_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+const DataBlock& BlockPool::GetZeroBlock() {
+  return zero_block_;
+}
+
+void* BlockPool::GetStorage() {
+  return blocks_;
+}
+
+size_t BlockPool::GetStorageBytes() {
+  return blocks_ != nullptr ? kPoolBytes : 0;
+}
+
+uint32_t BlockPool::GetPageCount() {
+  return page_count_;
+}
+
+uint32_t BlockPool::GetPagesInUse() {
+  return pages_in_use_.load(std::memory_order_relaxed);
+}
+
+uint32_t BlockPool::GetFailedAllocations() {
+  return failed_allocations_.load(std::memory_order_relaxed);
+}
+
+BlockPool& BlockPool::getInstance() {
+  static BlockPool singleton;
+  return singleton;
+}
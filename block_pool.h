@@ -0,0 +1,56 @@
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "data_block.h"
+
+// Preallocated pool of track pages, each page is BLOCKS_PER_PAGE DataBlocks.
+// Allocate and Release are lock-free and don't touch the heap so they can be
+// called from the audio thread. Free pages are kept on a stack whose head
+// carries a tag to avoid the ABA problem
+//
+// Storage is an anonymous mapping, the OS hands out zero filled memory on first
+// touch so nothing is written at startup and untouched pages cost nothing
+class BlockPool {
+  DataBlock *blocks_;
+  uint32_t page_count_;
+  // next free page for each page on the free list
+  std::vector<uint32_t> next_;
+  // page needs zeroing before it is handed out again
+  std::vector<uint8_t> dirty_;
+  // tag in the upper 32 bits, page index in the lower
+  std::atomic<uint64_t> free_head_;
+  std::atomic<uint32_t> pages_in_use_;
+  std::atomic<uint32_t> failed_allocations_;
+  // Read by tracks for blocks that have never been written
+  DataBlock zero_block_;
+
+  BlockPool();
+  ~BlockPool();
+  BlockPool(const BlockPool& other);
+  BlockPool& operator=(const BlockPool& other);
+
+  public:
+  static const uint32_t kNoPage = 0xFFFFFFFF;
+
+  // Returns a zeroed page or nullptr when the pool is exhausted
+  DataBlock* Allocate();
+  void Release(DataBlock *page);
+
+  const DataBlock& GetZeroBlock();
+  // Backing storage, for locking and pre-faulting at startup
+  void* GetStorage();
+  size_t GetStorageBytes();
+  uint32_t GetPageCount();
+  uint32_t GetPagesInUse();
+  uint32_t GetFailedAllocations();
+
+  static BlockPool& getInstance();
+};
+
+#endif // BLOCK_POOL_H
@@ -0,0 +1,184 @@
+#include "control_command.h"
+#include "rt_log.h"
+
+ControlCommand MakeControlCommand(InputGpio &gi) {
+  ControlCommand command;
+  command.event = InputProcessedEvent::kNo;
+  if (gi.LastEventWasDown()) {
+    command.event = InputProcessedEvent::kDown;
+  } else if (gi.LastEventWasDoubleDown()) {
+    command.event = InputProcessedEvent::kDoubleDown;
+  } else if (gi.LastEventWasLongPulse()) {
+    command.event = InputProcessedEvent::kLongPulse;
+  } else if (gi.LastEventWasShortPulse()) {
+    command.event = InputProcessedEvent::kShortPulse;
+  } else if (gi.LastEventWasUp()) {
+    command.event = InputProcessedEvent::kUp;
+  }
+  command.track = gi.GetLastTrack();
+  command.group = gi.GetLastGroup();
+  command.for_track = gi.LastEventWasForTrack();
+  command.timestamp_ns = gi.GetLastEventTime();
+  command.target_frame = 0;
+  return command;
+}
+
+void DispatchControlCommand(const ControlCommand &command, TrackManager &tm, GroupManager &gm) {
+  bool is_down = command.event == InputProcessedEvent::kDown;
+  if (gm.IsStateAddTrack() && is_down && command.for_track) {
+    // This adds tracks to group - redundant but in gpio should only send the events
+    // it doesn't have to know about the innerworkings of events
+    gm.StateProcess(tm, command.group, command.track);
+#ifdef DTEST_GPIO_VERBOSE
+    gm.DisplayGroups();
+#endif
+    return;
+  }
+  if (gm.IsStateRemoveTracks() && is_down && command.for_track) {
+    gm.StateProcess(tm, command.group, command.track);
+#ifdef DTEST_GPIO_VERBOSE
+    gm.DisplayGroups();
+#endif
+    return;
+  }
+
+  // Use IsTrackMemberOfGroup to prevent tracks from other groups interfering with
+  // active group
+  if (command.for_track && !gm.IsTrackMemberOfGroup(command.track, command.group)) {
+    return;
+  }
+  switch (command.event) {
+    case InputProcessedEvent::kDown:
+#ifdef DTEST_GPIO_VERBOSE
+      RT_LOG("E:Down, %s%u", command.for_track ? "T:" : "G:",
+             command.for_track ? command.track : command.group);
+#endif
+      if (command.for_track) {
+        tm.HandleDownEvent(command.track);
+      } else {
+        gm.HandleDownEvent(tm, command.group, command.track);
+      }
+      break;
+    case InputProcessedEvent::kDoubleDown:
+#ifdef DTEST_GPIO_VERBOSE
+      RT_LOG("E:DoubleDown, %s%u", command.for_track ? "T:" : "G:",
+             command.for_track ? command.track : command.group);
+#endif
+      if (command.for_track) {
+        tm.HandleDoubleDownEvent(command.track);
+      } else {
+        gm.HandleDoubleDownEvent(tm, command.group, command.track);
+      }
+      break;
+    case InputProcessedEvent::kLongPulse:
+#ifdef DTEST_GPIO_VERBOSE
+      RT_LOG("E:LongPulse, %s%u", command.for_track ? "T:" : "G:",
+             command.for_track ? command.track : command.group);
+#endif
+      if (command.for_track) {
+        tm.HandleLongPulseEvent(command.track);
+      } else {
+        gm.HandleLongPulseEvent(tm, command.group, command.track);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+CommandScheduler::CommandScheduler() {
+  has_next_command_ = false;
+  frame_count_ = 0;
+  late_commands_ = 0;
+  clock_sequence_.store(0);
+  period_frame_.store(0);
+  period_time_ns_.store(0);
+  sample_rate_.store(DEFAULT_SAMPLE_RATE);
+  schedule_ahead_frames_.store(COMMAND_SCHEDULE_AHEAD_FRAMES);
+}
+
+void CommandScheduler::SetSampleRate(uint32_t sample_rate) {
+  sample_rate_.store(sample_rate);
+}
+
+void CommandScheduler::SetScheduleAheadFrames(uint32_t frames) {
+  schedule_ahead_frames_.store(frames);
+}
+
+uint64_t CommandScheduler::FrameForTime(uint64_t timestamp_ns) {
+  uint32_t sequence;
+  uint64_t frame;
+  uint64_t time_ns;
+  do {
+    sequence = clock_sequence_.load(std::memory_order_acquire);
+    frame = period_frame_.load(std::memory_order_relaxed);
+    time_ns = period_time_ns_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((sequence & 0x1) || sequence != clock_sequence_.load(std::memory_order_relaxed));
+  if (time_ns == 0 || timestamp_ns == 0) { return 0; }
+
+  // The event may be before or after the start of the period
+  int64_t offset_ns = (int64_t)(timestamp_ns - time_ns);
+  int64_t target = (int64_t)frame + offset_ns * (int64_t)sample_rate_.load() / 1000000000LL
+                   + schedule_ahead_frames_.load();
+  if (target < 0) { target = 0; }
+  return (uint64_t)target;
+}
+
+bool CommandScheduler::Push(const ControlCommand &command) {
+  ControlCommand scheduled = command;
+  if (scheduled.target_frame == 0) {
+    scheduled.target_frame = FrameForTime(scheduled.timestamp_ns);
+  }
+  return commands_.Push(scheduled);
+}
+
+void CommandScheduler::StartPeriod(uint64_t now_ns) {
+  uint32_t sequence = clock_sequence_.load(std::memory_order_relaxed);
+  clock_sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  period_frame_.store(frame_count_, std::memory_order_relaxed);
+  period_time_ns_.store(now_ns, std::memory_order_relaxed);
+  clock_sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+uint32_t CommandScheduler::FramesToNextCommand(uint32_t frames_left) {
+  if (!has_next_command_) {
+    if (!commands_.Pop(next_command_)) { return frames_left; }
+    has_next_command_ = true;
+  }
+  if (next_command_.target_frame <= frame_count_) { return frames_left; }
+  return (uint32_t)std::min<uint64_t>(frames_left, next_command_.target_frame - frame_count_);
+}
+
+// Commands stay in order, a command waiting for its frame holds back the ones
+// queued after it
+bool CommandScheduler::PopDue(ControlCommand &command) {
+  if (!has_next_command_) {
+    if (!commands_.Pop(next_command_)) { return false; }
+    has_next_command_ = true;
+  }
+  if (next_command_.target_frame > frame_count_) { return false; }
+  if (next_command_.target_frame != 0 && next_command_.target_frame < frame_count_) {
+    late_commands_++;
+  }
+  command = next_command_;
+  has_next_command_ = false;
+  return true;
+}
+
+void CommandScheduler::Advance(uint32_t frames) {
+  frame_count_ += frames;
+}
+
+uint64_t CommandScheduler::GetCurrentFrame() {
+  return frame_count_;
+}
+
+uint32_t CommandScheduler::GetLateCommands() {
+  return late_commands_;
+}
+
+uint32_t CommandScheduler::GetQueueDepth() {
+  return commands_.GetCount();
+}
@@ -0,0 +1,81 @@
+#ifndef CONTROL_COMMAND_H
+#define CONTROL_COMMAND_H
+
+#include "track_manager.h"
+#include "group_manager.h"
+#include "input_gpio.h"
+#include "spsc_ring.h"
+
+// Commands carry an input event from the control thread to the audio thread,
+// which applies them at the frame they are scheduled for so track and group
+// state only ever changes on the audio thread
+#define CONTROL_QUEUE_SIZE 64
+// Commands are scheduled this far after the button press, it must cover the
+// control thread's latency plus one period, 256 frames is 5.3ms at 48kHz
+#define COMMAND_SCHEDULE_AHEAD_FRAMES 256
+#define DEFAULT_SAMPLE_RATE 48000
+
+struct ControlCommand {
+  InputProcessedEvent event;
+  uint32_t track;
+  uint32_t group;
+  bool for_track;
+  uint64_t timestamp_ns;   // CLOCK_MONOTONIC of the input event, 0 if unknown
+  uint64_t target_frame;   // audio frame to apply at, 0 for straight away
+};
+
+// Snapshot of the last event processed by InputGpio
+ControlCommand MakeControlCommand(InputGpio &gi);
+// Applies a command to the track and group managers, call from the audio thread
+void DispatchControlCommand(const ControlCommand &command, TrackManager &tm, GroupManager &gm);
+
+// Applies each command at a chosen audio frame. The audio thread counts every
+// frame it processes and publishes the frame count and time at the start of
+// each period, the control thread turns an event's timestamp into the frame it
+// should take effect at, a fixed time after the press. The audio thread splits
+// its period at the frame a command is due, so punch points don't depend on
+// when the control thread got to run. Periods without a due command aren't split.
+// Frames are counted from when processing started, unlike the master index they
+// never wrap
+class CommandScheduler {
+  SpscRing<ControlCommand, CONTROL_QUEUE_SIZE> commands_;
+  // Audio thread only
+  ControlCommand next_command_;
+  bool has_next_command_;
+  uint64_t frame_count_;
+  uint32_t late_commands_;
+
+  // Timeline at the start of the last period, written by the audio thread and
+  // read by the control thread under the sequence count, odd while writing
+  std::atomic<uint32_t> clock_sequence_;
+  std::atomic<uint64_t> period_frame_;
+  std::atomic<uint64_t> period_time_ns_;
+  std::atomic<uint32_t> sample_rate_;
+  std::atomic<uint32_t> schedule_ahead_frames_;
+
+  public:
+  CommandScheduler();
+  void SetSampleRate(uint32_t sample_rate);
+  void SetScheduleAheadFrames(uint32_t frames);
+
+  // Control thread
+  // Frame an event at timestamp_ns should take effect at, 0 before the first period
+  uint64_t FrameForTime(uint64_t timestamp_ns);
+  // Schedules commands with a timestamp, false if the queue is full
+  bool Push(const ControlCommand &command);
+
+  // Audio thread
+  void StartPeriod(uint64_t now_ns);
+  // Frames that can be processed before the next command is due
+  uint32_t FramesToNextCommand(uint32_t frames_left);
+  // Next command due at the current frame, call until it returns false
+  bool PopDue(ControlCommand &command);
+  void Advance(uint32_t frames);
+  uint64_t GetCurrentFrame();
+  // Commands applied after their target frame, the control thread was too late
+  uint32_t GetLateCommands();
+  // Commands waiting in the queue, not counting one held until its frame
+  uint32_t GetQueueDepth();
+};
+
+#endif // CONTROL_COMMAND_H
@@ -0,0 +1,150 @@
+#include <iostream>
+#include "dsp_load.h"
+
+DspLoadMonitor::DspLoadMonitor() {
+  for (auto &bucket : buckets_) {
+    bucket.store(0);
+  }
+  cycles_.store(0);
+  cycle_sum_ns_.store(0);
+  period_sum_ns_.store(0);
+  worst_ns_.store(0);
+  worst_load_permille_.store(0);
+  late_cycles_.store(0);
+  dropped_records_.store(0);
+  xruns_.store(0);
+  xruns_seen_ = 0;
+}
+
+// Single writer, loads and stores rather than read-modify-writes
+static inline void Increment(std::atomic<uint64_t> &counter, uint64_t amount) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+bool DspLoadMonitor::AddCycle(uint64_t cycle_ns, uint64_t period_ns, OverrunCause &cause) {
+  uint64_t us = cycle_ns / 1000;
+  uint32_t bucket = 0;
+  while (us > 1 && bucket < LATENCY_BUCKET_COUNT - 1) {
+    us >>= 1;
+    bucket++;
+  }
+  buckets_[bucket].store(buckets_[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  Increment(cycle_sum_ns_, cycle_ns);
+  Increment(period_sum_ns_, period_ns);
+  if (cycle_ns > worst_ns_.load(std::memory_order_relaxed)) {
+    worst_ns_.store(cycle_ns, std::memory_order_relaxed);
+  }
+  uint32_t load = period_ns != 0 ? cycle_ns * 1000 / period_ns : 0;
+  if (load > worst_load_permille_.load(std::memory_order_relaxed)) {
+    worst_load_permille_.store(load, std::memory_order_relaxed);
+  }
+  // Counted last, a reader seeing the count sees the cycle's time
+  Increment(cycles_, 1);
+
+  // Lateness is counted whatever the cause recorded, an xrun takes precedence
+  bool late = cycle_ns > period_ns;
+  if (late) {
+    Increment(late_cycles_, 1);
+  }
+  uint32_t xruns = xruns_.load(std::memory_order_relaxed);
+  if (xruns != xruns_seen_) {
+    xruns_seen_ = xruns;
+    cause = OverrunCause::kXrun;
+    return true;
+  }
+  if (late) {
+    cause = OverrunCause::kLate;
+    return true;
+  }
+  return false;
+}
+
+void DspLoadMonitor::AddOverrun(const OverrunRecord &record) {
+  if (!overruns_.Push(record)) {
+    dropped_records_.store(dropped_records_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+}
+
+// JACK calls this from its own thread
+void DspLoadMonitor::AddXrun() {
+  xruns_.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t DspLoadMonitor::GetCycleCount() {
+  return cycles_.load(std::memory_order_relaxed);
+}
+
+uint32_t DspLoadMonitor::GetBucket(uint32_t bucket) {
+  if (bucket >= LATENCY_BUCKET_COUNT) { return 0; }
+  return buckets_[bucket].load(std::memory_order_relaxed);
+}
+
+uint64_t DspLoadMonitor::GetWorstCycleNs() {
+  return worst_ns_.load(std::memory_order_relaxed);
+}
+
+uint32_t DspLoadMonitor::GetMeanLoadPermille() {
+  uint64_t period_ns = period_sum_ns_.load(std::memory_order_relaxed);
+  if (period_ns == 0) { return 0; }
+  return cycle_sum_ns_.load(std::memory_order_relaxed) * 1000 / period_ns;
+}
+
+uint32_t DspLoadMonitor::GetWorstLoadPermille() {
+  return worst_load_permille_.load(std::memory_order_relaxed);
+}
+
+uint64_t DspLoadMonitor::GetLateCycles() {
+  return late_cycles_.load(std::memory_order_relaxed);
+}
+
+uint32_t DspLoadMonitor::GetXruns() {
+  return xruns_.load(std::memory_order_relaxed);
+}
+
+uint32_t DspLoadMonitor::GetDroppedRecords() {
+  return dropped_records_.load(std::memory_order_relaxed);
+}
+
+uint32_t DspLoadMonitor::GetQueuedOverruns() {
+  return overruns_.GetCount();
+}
+
+bool DspLoadMonitor::PopOverrun(OverrunRecord &record) {
+  return overruns_.Pop(record);
+}
+
+void DspLoadMonitor::Print(const char *name) {
+  uint64_t cycles = GetCycleCount();
+  if (cycles == 0) {
+    std::cout << name << ": no cycles" << std::endl;
+    return;
+  }
+  uint32_t mean = GetMeanLoadPermille();
+  uint32_t worst = GetWorstLoadPermille();
+  std::cout << name << ": cycles " << cycles
+            << ", mean " << cycle_sum_ns_.load(std::memory_order_relaxed) / cycles / 1000 << "us"
+            << " (" << mean / 10 << "." << mean % 10 << "%)"
+            << ", worst " << GetWorstCycleNs() / 1000 << "us"
+            << " (" << worst / 10 << "." << worst % 10 << "%)"
+            << ", late " << GetLateCycles()
+            << ", xruns " << GetXruns() << std::endl;
+  for (uint32_t bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++) {
+    uint32_t count = GetBucket(bucket);
+    if (count == 0) { continue; }
+    std::cout << "    <" << (2ULL << bucket) << "us: " << count << std::endl;
+  }
+}
+
+void PrintOverrunRecord(const OverrunRecord &record) {
+  std::cout << (record.cause == OverrunCause::kXrun ? "xrun" : "late")
+            << ": cycle " << record.cycle_ns / 1000 << "us of " << record.period_ns / 1000 << "us"
+            << ", " << record.nframes << " frames"
+            << ", master " << record.master_index << "/" << record.master_end_index
+            << std::hex
+            << ", playing 0x" << record.tracks_playing
+            << ", muted 0x" << record.tracks_muted
+            << ", recording 0x" << record.tracks_recording
+            << std::dec
+            << ", group " << (int)record.active_group
+            << ", track " << (int)record.last_track << std::endl;
+}
@@ -0,0 +1,84 @@
+#ifndef DSP_LOAD_H
+#define DSP_LOAD_H
+
+#include <array>
+#include <atomic>
+#include <stdint.h>
+#include "latency_histogram.h"
+#include "spsc_ring.h"
+
+// Time taken by each audio cycle against the period it had, the cycles that
+// overran and the xruns JACK reported. The audio thread records without
+// locking or allocating, any other thread can read the counters while it runs
+// and one thread can take the overrun records
+#define DSP_OVERRUN_QUEUE_SIZE 64
+
+enum class OverrunCause : uint8_t {
+  kLate = 0,  // The cycle took longer than its period
+  kXrun       // JACK reported an xrun since the last cycle
+};
+
+// Engine state at the end of a cycle that overran
+struct OverrunRecord {
+  OverrunCause cause;
+  uint64_t timestamp_ns;    // CLOCK_MONOTONIC at the start of the cycle
+  uint32_t cycle_ns;
+  uint32_t period_ns;
+  uint32_t nframes;
+  uint32_t master_index;
+  uint32_t master_end_index;
+  uint16_t tracks_playing;  // Includes repeat
+  uint16_t tracks_muted;
+  uint16_t tracks_recording; // Includes overdub
+  uint8_t active_group;
+  uint8_t last_track;
+};
+
+class DspLoadMonitor {
+  // Same buckets as LatencyHistogram. Written by the audio thread only, so
+  // plain stores are enough, readers may see one cycle's fields half updated
+  std::array<std::atomic<uint32_t>, LATENCY_BUCKET_COUNT> buckets_;
+  std::atomic<uint64_t> cycles_;
+  std::atomic<uint64_t> cycle_sum_ns_;
+  std::atomic<uint64_t> period_sum_ns_;
+  std::atomic<uint64_t> worst_ns_;
+  std::atomic<uint32_t> worst_load_permille_;
+  std::atomic<uint64_t> late_cycles_;
+  std::atomic<uint32_t> dropped_records_;
+  // From the JACK xrun callback, xruns_seen_ is the audio thread's count
+  std::atomic<uint32_t> xruns_;
+  uint32_t xruns_seen_;
+  SpscRing<OverrunRecord, DSP_OVERRUN_QUEUE_SIZE> overruns_;
+
+  public:
+  DspLoadMonitor();
+
+  // Audio thread
+  // Adds a cycle, true if it should be recorded with AddOverrun - it was
+  // late or an xrun was reported since the last cycle
+  bool AddCycle(uint64_t cycle_ns, uint64_t period_ns, OverrunCause &cause);
+  void AddOverrun(const OverrunRecord &record);
+
+  // Any thread
+  void AddXrun();
+  uint64_t GetCycleCount();
+  uint32_t GetBucket(uint32_t bucket);
+  uint64_t GetWorstCycleNs();
+  // Busy time over period time, per mille
+  uint32_t GetMeanLoadPermille();
+  uint32_t GetWorstLoadPermille();
+  uint64_t GetLateCycles();
+  uint32_t GetXruns();
+  // Overrun records lost because nobody took them
+  uint32_t GetDroppedRecords();
+  uint32_t GetQueuedOverruns();
+  // One reader thread only, false when there are none
+  bool PopOverrun(OverrunRecord &record);
+  // name: cycles, mean and worst time and load, late cycles, xruns then
+  // each used bucket
+  void Print(const char *name);
+};
+
+void PrintOverrunRecord(const OverrunRecord &record);
+
+#endif // DSP_LOAD_H
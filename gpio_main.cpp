@@ -13,19 +13,54 @@
 #include "input_gpio.h"
 #include "output_i2c.h"
 #include "audio_jack.h"
+#include "memory_lock.h"
+#include "rt_log.h"
+#include "latency_histogram.h"
+#include "telemetry.h"
 
 static InputGpio gi;
 static OutputI2C oi;
 static TrackManager tm;
 static GroupManager gm;
 static AudioJack jack;
+// Track and master gains, set from the control thread
+static MixParameters mix_parameters;
+// Live metrics for the telemetry reader
+static TelemetryWriter telemetry;
+
+#define DSP_LOAD_REPORT_SECONDS 10
+
+// Low priority, prints each overrun as it's taken from the audio thread's
+// queue and the cycle time summary every DSP_LOAD_REPORT_SECONDS
+static void DspLoadReporter() {
+  DspLoadMonitor &dsp_load = jack.GetDspLoad();
+  uint32_t seconds = 0;
+  uint32_t dropped = 0;
+  while (1) {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    OverrunRecord record;
+    while (dsp_load.PopOverrun(record)) {
+      PrintOverrunRecord(record);
+    }
+    if (dsp_load.GetDroppedRecords() != dropped) {
+      dropped = dsp_load.GetDroppedRecords();
+      std::cout << "Overrun records dropped: " << dropped << std::endl;
+    }
+    if (++seconds % DSP_LOAD_REPORT_SECONDS == 0) {
+      dsp_load.Print("dsp_load");
+    }
+  }
+}
 
 int
 main (int argc, char *argv[])
 {
 
+  // Trace output from the audio thread is printed by the drain thread
+  RtLog::getInstance().StartDrainThread();
+  tm.SetMixParameters(&mix_parameters);
   jack.SetTrackManagerPtr(&tm, nullptr);
-  jack.SetInputGpioPtr(&gi);
+  jack.SetGroupManagerPtr(&gm);
   jack.Init(argc, argv);
 
 //int main() {
@@ -40,77 +75,47 @@ main (int argc, char *argv[])
 
   tm.SetOutputI2CPtr(&oi);
   gm.SetOutputI2CPtr(&oi);
+  std::cout << "Mixer kernel: " << MixerGetKernelName(MixerGetKernel()) << std::endl;
+  std::cout << "Hardware backend: " << HalGetBackendName(HalGetBackend()) << std::endl;
 
-  struct timeval tstart, tend, tdiff;
   auto th_id = std::this_thread::get_id();
   std::cout << "MainThread ID, "<< th_id << std::endl;
 
   gi.Reset();
   std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
+#ifdef LOCK_AUDIO_MEMORY
+  // Track storage must be resident before the first record
+  PrintMemoryLockReport(LockAudioMemory());
+#endif
+
   std::cout << "Enable Jack Audio Processing" << std::endl;
+  jack.SetZeroCopyIO(true);
+  if (telemetry.Open()) {
+    jack.SetTelemetryWriter(&telemetry);
+  } else {
+    std::cout << "Telemetry shared memory not available" << std::endl;
+  }
   jack.EnableJackAudioProcessing();
+  std::thread dsp_load_thread(DspLoadReporter);
+  dsp_load_thread.detach();
   std::cout << "Entering while1" << std::endl;
 
-  // Hammer on this but need to handle multiple events case!
+  // Sleeps until the input layer signals an event, every queued event, oldest
+  // first, is handed to the audio thread, which applies them before the next period
+  LatencyHistogram press_to_command;
   while(1) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    if (gi.ProcessAndHandleInputEvents()) {
-      gettimeofday(&tstart, NULL);
-      if (gm.IsStateAddTrack() && gi.LastEventWasDown() && gi.LastEventWasForTrack()) {
-        //gm.AddTrackToGroup(gi.GetLastTrack(), gi.GetLastGroup());
-	// This adds tracks to group - redundant but in gpio should only send the events
-	// it doesn't have to know about the innerworkings of events
-        gm.StateProcess(tm, gi.GetLastGroup(), gi.GetLastTrack());
-	gm.DisplayGroups();
-      } else if (gm.IsStateRemoveTracks() && gi.LastEventWasDown() && gi.LastEventWasForTrack()) {
-        //gm.AddTrackToGroup(gi.GetLastTrack(), gi.GetLastGroup());
-	// This adds tracks to group - redundant but in gpio should only send the events
-	// it doesn't have to know about the innerworkings of events
-        gm.StateProcess(tm, gi.GetLastGroup(), gi.GetLastTrack());
-	gm.DisplayGroups();
-      } else {
-
-      // Use IsTrackMemberOfGroup to prevent tracks from other groups interfering with
-      // active group
-      if (gi.LastEventWasDown()) {
-        if (gi.LastEventWasForTrack()) {
-	  if (gm.IsTrackMemberOfGroup(gi.GetLastTrack(), gi.GetLastGroup())) {
-            std::cout << "E:Down, T:" << gi.GetLastTrack() << std::endl;
-	    tm.HandleDownEvent(gi.GetLastTrack());
-	  }
-        } else {
-          std::cout << "E:Down, G:" << gi.GetLastGroup() << std::endl;
-	  gm.HandleDownEvent(tm, gi.GetLastGroup(), gi.GetLastTrack());
-        }
+    gi.WaitForEvents(-1);
+    while (gi.ProcessAndHandleInputEvents()) {
+      if (!jack.PushCommand(MakeControlCommand(gi))) {
+        std::cout << "Command queue full, event dropped" << std::endl;
       }
-      if (gi.LastEventWasDoubleDown()) {
-        if (gi.LastEventWasForTrack()) {
-	  if (gm.IsTrackMemberOfGroup(gi.GetLastTrack(), gi.GetLastGroup())) {
-            std::cout << "E:DoubleDown, T:" << gi.GetLastTrack() << std::endl;
-	    tm.HandleDoubleDownEvent(gi.GetLastTrack());
-	  }
-        } else {
-          std::cout << "E:DoubleDown, G:" << gi.GetLastGroup() << std::endl;
-	  gm.HandleDoubleDownEvent(tm, gi.GetLastGroup(), gi.GetLastTrack());
-        }
-      }
-      if (gi.LastEventWasLongPulse()) {
-        if (gi.LastEventWasForTrack()) {
-	  if (gm.IsTrackMemberOfGroup(gi.GetLastTrack(), gi.GetLastGroup())) {
-            std::cout << "E:LongPulse, T:" << gi.GetLastTrack() << std::endl;
-	    tm.HandleLongPulseEvent(gi.GetLastTrack());
-	  }
-        } else {
-          std::cout << "E:LongPulse, G:" << gi.GetLastGroup() << std::endl;
-	  gm.HandleLongPulseEvent(tm, gi.GetLastGroup(), gi.GetLastTrack());
-        }
-      }
-
+      press_to_command.Add(MonotonicNowNs() - gi.GetLastEventTime());
+#ifdef DTEST_GPIO
+      if (press_to_command.GetCount() % 64 == 0) {
+        press_to_command.Print("press_to_command");
       }
-      gettimeofday(&tend, NULL);
-      timersub(&tend, &tstart, &tdiff);
-      std::cout << "Processing Time S:" << std::dec << tdiff.tv_sec << ":" << std::dec << tdiff.tv_usec << std::endl;
+#endif
     }
   }
 
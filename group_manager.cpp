@@ -1,5 +1,6 @@
 #include "group_manager.h"
 #include "group_manager_states.h"
+#include "rt_log.h"
 
 // Default Constructor - set all data to zero
 GroupManager::GroupManager() {
@@ -12,13 +13,16 @@ GroupManager::GroupManager() {
   for (auto &i : group_master_end_index) {
     i = 0;
   }
+  for (auto &o : group_master_end_offset) {
+    o = 0;
+  }
   output_i2c = nullptr;
 }
 
 void GroupManager::AddTrackToGroup(uint32_t track_number, uint8_t group_number) {
   groups.at(group_number) |= 0x1 << track_number;
 #ifdef DTEST_VERBOSE //_GM
-  std::cout << "GM::ATTG" << std::endl;
+  RT_LOG("GM::ATTG");
 #endif
   if (output_i2c != nullptr) {
     // This will kickstart a detached thread in the output_i2c object
@@ -54,6 +58,7 @@ void GroupManager::RemoveTrackFromGroup(uint32_t track_number, uint8_t group_num
 #ifdef DTEST_GM
 void GroupManager::SetGroupMasterEndIndex(uint32_t end, uint8_t group_number) {
   group_master_end_index.at(group_number) = end;
+  group_master_end_offset.at(group_number) = 0;
 }
 #endif
 
@@ -62,7 +67,7 @@ void GroupManager::SetGroupMasterEndIndex(uint32_t end, uint8_t group_number) {
 // active group
 void GroupManager::SilenceAllTracks(TrackManager &tm) {
 #ifdef DTEST_VERBOSE //_GM
-  std::cout << "GM::SAT" << std::endl;
+  RT_LOG("GM::SAT");
 #endif
   tm.HandleMuteUnmuteTracks(0xFFFF);
 }
@@ -75,7 +80,7 @@ void GroupManager::GroupInactive(uint8_t group_number) {
 
 void GroupManager::UnmuteActiveGroupTracks(TrackManager &tm) {
 #ifdef DTEST_VERBOSE //_GM
-  std::cout << "GM::UAGT" << std::endl;
+  RT_LOG("GM::UAGT");
 #endif
   tm.HandleMuteUnmuteTracks(~(groups.at(active_group)));
   if (output_i2c != nullptr) {
@@ -99,12 +104,12 @@ void GroupManager::GroupActive(uint8_t new_group) {
 }
 void GroupManager::SetActiveGroup(uint8_t new_group, TrackManager &tm) {
 #ifdef DTEST_VERBOSE //_GM
-  std::cout << "GM::SAG from " << unsigned(active_group) << " to  " << unsigned(new_group) << std::endl;
+  RT_LOG("GM::SAG from %u to  %u", unsigned(active_group), unsigned(new_group));
 #endif
 
   if (new_group == active_group) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "GM::SAG return early, grp " << unsigned(new_group) << std::endl;
+  RT_LOG("GM::SAG return early, grp %u", unsigned(new_group));
 #endif
     return;
   }
@@ -114,19 +119,21 @@ void GroupManager::SetActiveGroup(uint8_t new_group, TrackManager &tm) {
   // group should store master_end_index per group!
   if (active_group != MAX_GROUP_COUNT) {
     group_master_end_index.at(active_group) = tm.GetMasterEndIndex();
+    group_master_end_offset.at(active_group) = tm.GetMasterEndOffset();
   }
   active_group = new_group;
   // Load group's master end index
   tm.SetMasterEndIndex(group_master_end_index.at(active_group));
-  tm.SetMasterCurrentIndex(0);
+  tm.SetMasterEndOffset(group_master_end_offset.at(active_group));
+  tm.SetMasterCurrentIndex(0, true);
 
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "GM::SAG new active grp " << unsigned(new_group) << std::endl;
-  std::cout << "GM::SAGE new active grp master end index " << tm.GetMasterEndIndex() << std::endl;
+  RT_LOG("GM::SAG new active grp %u", unsigned(new_group));
+  RT_LOG("GM::SAGE new active grp master end index %u", tm.GetMasterEndIndex());
 #endif
   UnmuteActiveGroupTracks(tm);
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "GM::SAG exiting active_grp " << unsigned(active_group) << std::endl;
+  RT_LOG("GM::SAG exiting active_grp %u", unsigned(active_group));
 #endif
 }
 
@@ -139,10 +146,12 @@ void GroupManager::ResetActiveGroupToNone() {
 }
 
 void GroupManager::DisplayGroups() {
+  char text[RT_LOG_RECORD_SIZE];
+  int len = 0;
   for (auto &g : groups) {
-    std::cout << "0x" << std::hex << g << " ";
+    len += snprintf(text + len, sizeof(text) - len, "0x%x ", g);
   }
-  std::cout << std::endl;
+  RT_LOG("%s", text);
 }
 
 void GroupManager::HandleDownEvent(TrackManager &tm, uint32_t group_number, uint32_t track_number) {
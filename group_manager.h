@@ -24,6 +24,7 @@ class GroupManager {
    */
   std::array<uint16_t, MAX_GROUP_COUNT> groups;
   std::array<uint32_t, MAX_GROUP_COUNT> group_master_end_index;
+  std::array<uint32_t, MAX_GROUP_COUNT> group_master_end_offset;
   uint8_t active_group;
 
   GroupManagerState* current_state;
@@ -1,4 +1,5 @@
 #include "group_manager_states.h"
+#include "rt_log.h"
 
 /*
  * NOT_ACTIVE
@@ -23,26 +24,26 @@ void NotActive::active(GroupManager &gm, TrackManager &tm, uint32_t group_number
   // Event State Transitions
 void NotActive::handle_down_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << ":NOT_ACTIVE:HDE->ACTIVE" << std::endl;
+  RT_LOG("G:%u:NOT_ACTIVE:HDE->ACTIVE", group_number);
 #endif
   gm.SetState(Active::getInstance(), tm, group_number, track_number);
 }
 
 void NotActive::handle_double_down_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << ":NOT_ACTIVE:DDE" << std::endl;
+  RT_LOG("G:%u:NOT_ACTIVE:DDE", group_number);
 #endif
 }
 
 void NotActive::handle_short_pulse_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << ":NOT_ACTIVE:SPE" << std::endl;
+  RT_LOG("G:%u:NOT_ACTIVE:SPE", group_number);
 #endif
 }
 
 void NotActive::handle_long_pulse_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << "NOT_ACTIVE:LPE" << std::endl;
+  RT_LOG("G:%uNOT_ACTIVE:LPE", group_number);
 #endif
 }
 
@@ -79,12 +80,12 @@ void Active::active(GroupManager &gm, TrackManager &tm, uint32_t group_number, u
 void Active::handle_down_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
   if (gm.GetActiveGroup() == group_number) {
 #ifdef DTEST_VERBOSE_GM
-    std::cout << "G:" << group_number << ":ACTIVE:HDE->ADD_TRACK" << std::endl;
+    RT_LOG("G:%u:ACTIVE:HDE->ADD_TRACK", group_number);
 #endif
     gm.SetState(AddTrack::getInstance(), tm, group_number, track_number);
   } else {
 #ifdef DTEST_VERBOSE_GM
-    std::cout << "G:" << group_number << ":ACTIVE:HDE->ACTIVE_NEW_GROUP" << std::endl;
+    RT_LOG("G:%u:ACTIVE:HDE->ACTIVE_NEW_GROUP", group_number);
 #endif
     // If the group number is different, re-enter the Active state
     gm.SetState(Active::getInstance(), tm, group_number, track_number);
@@ -93,20 +94,20 @@ void Active::handle_down_event(GroupManager &gm, TrackManager &tm, uint32_t grou
 
 void Active::handle_double_down_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number <<  "ACTIVE:DDE->ADD_TRACK" << std::endl;
+  RT_LOG("G:%uACTIVE:DDE->ADD_TRACK", group_number);
 #endif
   gm.SetState(AddTrack::getInstance(), tm, group_number, track_number);
 }
 
 void Active::handle_short_pulse_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << "ACTIVE:SPE" << std::endl;
+  RT_LOG("G:%uACTIVE:SPE", group_number);
 #endif
 }
 
 void Active::handle_long_pulse_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << "ACTIVE:LPE" << std::endl;
+  RT_LOG("G:%uACTIVE:LPE", group_number);
 #endif
 }
 
@@ -134,7 +135,7 @@ void AddTrack::active(GroupManager &gm, TrackManager &tm, uint32_t group_number,
   // Event State Transitions
 void AddTrack::handle_down_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << "ADD_TRACK:HDE->ACTIVE" << std::endl;
+  RT_LOG("G:%uADD_TRACK:HDE->ACTIVE", group_number);
 #endif
   // ADD_TRACK->ACTIVE
   gm.SetState(Active::getInstance(), tm, group_number, track_number);
@@ -142,20 +143,20 @@ void AddTrack::handle_down_event(GroupManager &gm, TrackManager &tm, uint32_t gr
 
 void AddTrack::handle_double_down_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << "ADD_TRACK:DDE->NOT_ACTIVE" << std::endl;
+  RT_LOG("G:%uADD_TRACK:DDE->NOT_ACTIVE", group_number);
 #endif
   gm.SetState(NotActive::getInstance(), tm, group_number, track_number);
 }
 
 void AddTrack::handle_short_pulse_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << "ADD_TRACK:SPE" << std::endl;
+  RT_LOG("G:%uADD_TRACK:SPE", group_number);
 #endif
 }
 
 void AddTrack::handle_long_pulse_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << "ADD_TRACK:LPE->REMOVE_TRACKS" << std::endl;
+  RT_LOG("G:%uADD_TRACK:LPE->REMOVE_TRACKS", group_number);
 #endif
   // ADD_TRACK -> REMOVE_TRACKS
   gm.SetState(RemoveTracks::getInstance(), tm, group_number, track_number);
@@ -186,12 +187,12 @@ void RemoveTracks::active(GroupManager &gm, TrackManager &tm, uint32_t group_num
 void RemoveTracks::handle_down_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
   if (gm.GetActiveGroup() == group_number) {
 #ifdef DTEST_VERBOSE_GM
-    std::cout << "G:" << group_number << "REMOVE_TRACKS:HDE->NOT_ACTIVE" << std::endl;
+    RT_LOG("G:%uREMOVE_TRACKS:HDE->NOT_ACTIVE", group_number);
 #endif
     gm.SetState(NotActive::getInstance(), tm, group_number, track_number);
   } else {
 #ifdef DTEST_VERBOSE_GM
-    std::cout << "G:" << group_number << ":REMOVE_TRACKS:HDE->ACTIVE_NEW_GROUP" << std::endl;
+    RT_LOG("G:%u:REMOVE_TRACKS:HDE->ACTIVE_NEW_GROUP", group_number);
 #endif
     // If the group number is different, re-enter the Active state
     gm.SetState(Active::getInstance(), tm, group_number, track_number);
@@ -200,19 +201,19 @@ void RemoveTracks::handle_down_event(GroupManager &gm, TrackManager &tm, uint32_
 
 void RemoveTracks::handle_double_down_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << "REMOVE_TRACKS:DDE" << std::endl;
+  RT_LOG("G:%uREMOVE_TRACKS:DDE", group_number);
 #endif
 }
 
 void RemoveTracks::handle_short_pulse_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << "REMOVE_TRACKS:SPE" << std::endl;
+  RT_LOG("G:%uREMOVE_TRACKS:SPE", group_number);
 #endif
 }
 
 void RemoveTracks::handle_long_pulse_event(GroupManager &gm, TrackManager &tm, uint32_t group_number, uint32_t track_number) {
 #ifdef DTEST_VERBOSE_GM
-  std::cout << "G:" << group_number << "REMOVE_TRACKS:LPE" << std::endl;
+  RT_LOG("G:%uREMOVE_TRACKS:LPE", group_number);
 #endif
 }
 
@@ -0,0 +1,185 @@
+#include <unistd.h>
+#include "hal.h"
+#include "hal_sim.h"
+#include "latency_histogram.h"
+
+#ifdef HAVE_WIRINGPI
+#include <wiringPi.h>
+#include <wiringPiI2C.h>
+#endif
+
+/*
+ * wiringPi backend
+ */
+
+#ifdef HAVE_WIRINGPI
+static void WiringPiInputPullUp(int pin) {
+  pinMode(pin, INPUT);
+  pullUpDnControl(pin, PUD_UP);
+}
+
+static int WiringPiIsr(int pin, HalIsr isr) {
+  return wiringPiISR(pin, INT_EDGE_BOTH, isr);
+}
+
+// The ISR thread runs as soon as the kernel reports the edge
+static uint64_t WiringPiEdgeTimeNs(int pin) {
+  return MonotonicNowNs();
+}
+
+static int WiringPiI2CSetup(uint8_t addr) {
+  return wiringPiI2CSetup(addr);
+}
+
+static int WiringPiI2CWriteByte(int fd, uint8_t data) {
+  return wiringPiI2CWrite(fd, data);
+}
+
+static int WiringPiI2CWriteReg8(int fd, uint8_t reg, uint8_t value) {
+  return wiringPiI2CWriteReg8(fd, reg, value);
+}
+
+static int WiringPiI2CWriteReg16(int fd, uint8_t reg, uint16_t value) {
+  return wiringPiI2CWriteReg16(fd, reg, value);
+}
+
+static int WiringPiI2CReadReg8(int fd, uint8_t reg) {
+  return wiringPiI2CReadReg8(fd, reg);
+}
+
+// wiringPi has no block write, the i2c-dev fd takes the register then the data
+static bool WiringPiI2CWriteBurst(int fd, uint8_t reg, const uint8_t *data, uint32_t length) {
+  uint8_t buffer[256];
+  if (length + 1 > sizeof(buffer)) { return false; }
+  buffer[0] = reg;
+  for (uint32_t i = 0; i < length; i++) {
+    buffer[1 + i] = data[i];
+  }
+  return write(fd, buffer, 1 + length) == (ssize_t)(1 + length);
+}
+#endif
+
+/*
+ * Dispatch
+ */
+
+struct HalBackend {
+  int (*gpio_setup)();
+  void (*gpio_input_pull_up)(int pin);
+  int (*gpio_read)(int pin);
+  int (*gpio_isr)(int pin, HalIsr isr);
+  uint64_t (*gpio_edge_time_ns)(int pin);
+  int (*i2c_setup)(uint8_t addr);
+  int (*i2c_write)(int fd, uint8_t data);
+  int (*i2c_write_reg8)(int fd, uint8_t reg, uint8_t value);
+  int (*i2c_write_reg16)(int fd, uint8_t reg, uint16_t value);
+  int (*i2c_read_reg8)(int fd, uint8_t reg);
+  bool (*i2c_write_burst)(int fd, uint8_t reg, const uint8_t *data, uint32_t length);
+};
+
+static const HalBackend sim_backend = {
+  SimGpioSetup, SimGpioInputPullUp, SimGpioRead, SimGpioIsr, SimGpioEdgeTimeNs,
+  SimI2CSetup, SimI2CWrite, SimI2CWriteReg8, SimI2CWriteReg16, SimI2CReadReg8, SimI2CWriteBurst
+};
+
+#ifdef HAVE_WIRINGPI
+static const HalBackend wiring_pi_backend = {
+  wiringPiSetup, WiringPiInputPullUp, digitalRead, WiringPiIsr, WiringPiEdgeTimeNs,
+  WiringPiI2CSetup, WiringPiI2CWriteByte, WiringPiI2CWriteReg8, WiringPiI2CWriteReg16,
+  WiringPiI2CReadReg8, WiringPiI2CWriteBurst
+};
+static const HalBackend *hal_backend = &wiring_pi_backend;
+static HalBackendType hal_backend_type = HalBackendType::kWiringPi;
+#else
+static const HalBackend *hal_backend = &sim_backend;
+static HalBackendType hal_backend_type = HalBackendType::kSim;
+#endif
+
+bool HalIsBackendSupported(HalBackendType type) {
+  switch (type) {
+#ifdef HAVE_WIRINGPI
+    case HalBackendType::kWiringPi:
+      return true;
+#endif
+    case HalBackendType::kSim:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool HalSelectBackend(HalBackendType type) {
+  switch (type) {
+#ifdef HAVE_WIRINGPI
+    case HalBackendType::kWiringPi:
+      hal_backend = &wiring_pi_backend;
+      break;
+#endif
+    case HalBackendType::kSim:
+      hal_backend = &sim_backend;
+      break;
+    default:
+      return false;
+  }
+  hal_backend_type = type;
+  return true;
+}
+
+HalBackendType HalGetBackend() {
+  return hal_backend_type;
+}
+
+const char* HalGetBackendName(HalBackendType type) {
+  switch (type) {
+    case HalBackendType::kWiringPi:
+      return "wiringpi";
+    case HalBackendType::kSim:
+      return "sim";
+    default:
+      return "unknown";
+  }
+}
+
+int HalGpioSetup() {
+  return hal_backend->gpio_setup();
+}
+
+void HalGpioInputPullUp(int pin) {
+  hal_backend->gpio_input_pull_up(pin);
+}
+
+int HalGpioRead(int pin) {
+  return hal_backend->gpio_read(pin);
+}
+
+int HalGpioIsr(int pin, HalIsr isr) {
+  return hal_backend->gpio_isr(pin, isr);
+}
+
+uint64_t HalGpioEdgeTimeNs(int pin) {
+  return hal_backend->gpio_edge_time_ns(pin);
+}
+
+int HalI2CSetup(uint8_t addr) {
+  return hal_backend->i2c_setup(addr);
+}
+
+int HalI2CWrite(int fd, uint8_t data) {
+  return hal_backend->i2c_write(fd, data);
+}
+
+int HalI2CWriteReg8(int fd, uint8_t reg, uint8_t value) {
+  return hal_backend->i2c_write_reg8(fd, reg, value);
+}
+
+int HalI2CWriteReg16(int fd, uint8_t reg, uint16_t value) {
+  return hal_backend->i2c_write_reg16(fd, reg, value);
+}
+
+int HalI2CReadReg8(int fd, uint8_t reg) {
+  return hal_backend->i2c_read_reg8(fd, reg);
+}
+
+bool HalI2CWriteBurst(int fd, uint8_t reg, const uint8_t *data, uint32_t length) {
+  return hal_backend->i2c_write_burst(fd, reg, data, length);
+}
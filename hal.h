@@ -0,0 +1,51 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+// Hardware access for the button inputs and the LED/display outputs.
+// The wiringPi backend drives the Pi's GPIO and I2C, the simulated backend
+// runs on any Linux box - pin edges are injected with their timestamps and
+// I2C writes are kept as a register trace, see hal_sim.h
+
+#define HAL_LOW 0
+#define HAL_HIGH 1
+// wiringPi pin numbers are below this
+#define HAL_GPIO_PIN_COUNT 32
+
+enum class HalBackendType {
+  kWiringPi = 0,  // Raspberry Pi, only when built with wiringPi
+  kSim,           // Plain Linux, always available
+  kCount
+};
+
+// Called on both edges of a pin, from a thread of the backend
+typedef void (*HalIsr)(void);
+
+// The default is wiringPi when it was found at build time, otherwise the
+// simulated backend. Select before initializing InputGpio and OutputI2C
+bool HalSelectBackend(HalBackendType type);
+bool HalIsBackendSupported(HalBackendType type);
+HalBackendType HalGetBackend();
+const char* HalGetBackendName(HalBackendType type);
+
+// GPIO, pins are wiringPi numbers
+int HalGpioSetup();
+// Input with the pull up on, buttons pull the pin low
+void HalGpioInputPullUp(int pin);
+int HalGpioRead(int pin);
+int HalGpioIsr(int pin, HalIsr isr);
+// CLOCK_MONOTONIC time of the edge being handled, call from the ISR
+uint64_t HalGpioEdgeTimeNs(int pin);
+
+// I2C, the fd returned by setup is negative if there's no device
+int HalI2CSetup(uint8_t addr);
+// Single byte, for devices taking commands without a register
+int HalI2CWrite(int fd, uint8_t data);
+int HalI2CWriteReg8(int fd, uint8_t reg, uint8_t value);
+int HalI2CWriteReg16(int fd, uint8_t reg, uint16_t value);
+int HalI2CReadReg8(int fd, uint8_t reg);
+// Auto-increment write of length bytes from reg, false if it didn't complete
+bool HalI2CWriteBurst(int fd, uint8_t reg, const uint8_t *data, uint32_t length);
+
+#endif // HAL_H
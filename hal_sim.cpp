@@ -0,0 +1,232 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "hal_sim.h"
+
+// fds handed out for I2C devices, never passed to the OS
+#define SIM_I2C_FD_BASE 0x1000
+#define SIM_I2C_ADDR_COUNT 128
+#define SIM_I2C_REGISTER_COUNT 256
+
+struct SimPin {
+  std::atomic<int> level;
+  std::atomic<uint64_t> edge_ns;
+  std::atomic<HalIsr> isr;
+};
+
+static std::array<SimPin, HAL_GPIO_PIN_COUNT> sim_pins;
+
+// Written from the LED worker, read from the test
+static std::mutex sim_i2c_mutex;
+static std::array<std::array<uint8_t, SIM_I2C_REGISTER_COUNT>, SIM_I2C_ADDR_COUNT> sim_i2c_registers;
+static std::vector<SimI2CTransaction> sim_i2c_trace;
+static uint32_t sim_i2c_clock_hz = SIM_I2C_DEFAULT_CLOCK_HZ;
+static bool sim_i2c_blocking = false;
+static uint8_t sim_i2c_fail_addr = 0;
+static uint8_t sim_i2c_fail_reg = 0;
+static uint32_t sim_i2c_fail_count = 0;
+
+static bool SimInit() {
+  SimReset();
+  return true;
+}
+static bool sim_initialized = SimInit();
+
+/*
+ * Test side
+ */
+
+void SimGpioSetLevel(int pin, int level, uint64_t timestamp_ns) {
+  if (pin < 0 || pin >= HAL_GPIO_PIN_COUNT) { return; }
+  SimPin &sim_pin = sim_pins[pin];
+  sim_pin.edge_ns.store(timestamp_ns);
+  if (sim_pin.level.exchange(level) == level) { return; }
+  HalIsr isr = sim_pin.isr.load();
+  if (isr != nullptr) {
+    isr();
+  }
+}
+
+void SimReset() {
+  for (auto &pin : sim_pins) {
+    pin.level.store(HAL_HIGH);
+    pin.edge_ns.store(0);
+    pin.isr.store(nullptr);
+  }
+  std::lock_guard<std::mutex> lock(sim_i2c_mutex);
+  for (auto &device : sim_i2c_registers) {
+    device.fill(0);
+  }
+  sim_i2c_trace.clear();
+  sim_i2c_fail_count = 0;
+}
+
+std::vector<SimI2CTransaction> SimI2CGetTrace() {
+  std::lock_guard<std::mutex> lock(sim_i2c_mutex);
+  return sim_i2c_trace;
+}
+
+void SimI2CClearTrace() {
+  std::lock_guard<std::mutex> lock(sim_i2c_mutex);
+  sim_i2c_trace.clear();
+}
+
+uint64_t SimI2CGetBusTimeNs() {
+  std::lock_guard<std::mutex> lock(sim_i2c_mutex);
+  uint64_t total = 0;
+  for (auto &transaction : sim_i2c_trace) {
+    total += transaction.cost_ns;
+  }
+  return total;
+}
+
+void SimI2CSetClock(uint32_t hz) {
+  std::lock_guard<std::mutex> lock(sim_i2c_mutex);
+  sim_i2c_clock_hz = hz != 0 ? hz : SIM_I2C_DEFAULT_CLOCK_HZ;
+}
+
+void SimI2CSetBlocking(bool blocking) {
+  std::lock_guard<std::mutex> lock(sim_i2c_mutex);
+  sim_i2c_blocking = blocking;
+}
+
+uint8_t SimI2CGetRegister(uint8_t addr, uint8_t reg) {
+  std::lock_guard<std::mutex> lock(sim_i2c_mutex);
+  return sim_i2c_registers[addr % SIM_I2C_ADDR_COUNT][reg];
+}
+
+void SimI2CFailWrites(uint8_t addr, uint8_t reg, uint32_t count) {
+  std::lock_guard<std::mutex> lock(sim_i2c_mutex);
+  sim_i2c_fail_addr = addr;
+  sim_i2c_fail_reg = reg;
+  sim_i2c_fail_count = count;
+}
+
+/*
+ * GPIO
+ */
+
+int SimGpioSetup() {
+  return 0;
+}
+
+void SimGpioInputPullUp(int pin) {
+  if (pin < 0 || pin >= HAL_GPIO_PIN_COUNT) { return; }
+  sim_pins[pin].level.store(HAL_HIGH);
+}
+
+int SimGpioRead(int pin) {
+  if (pin < 0 || pin >= HAL_GPIO_PIN_COUNT) { return HAL_HIGH; }
+  return sim_pins[pin].level.load();
+}
+
+int SimGpioIsr(int pin, HalIsr isr) {
+  if (pin < 0 || pin >= HAL_GPIO_PIN_COUNT) { return -1; }
+  sim_pins[pin].isr.store(isr);
+  return 0;
+}
+
+uint64_t SimGpioEdgeTimeNs(int pin) {
+  if (pin < 0 || pin >= HAL_GPIO_PIN_COUNT) { return 0; }
+  return sim_pins[pin].edge_ns.load();
+}
+
+/*
+ * I2C
+ */
+
+static bool SimI2CAddr(int fd, uint8_t &addr) {
+  if (fd < SIM_I2C_FD_BASE || fd >= SIM_I2C_FD_BASE + SIM_I2C_ADDR_COUNT) { return false; }
+  addr = fd - SIM_I2C_FD_BASE;
+  return true;
+}
+
+// 9 clocks a byte with the ack, plus start and stop, and a repeated start
+// for reads. Called with the lock held
+static uint32_t SimI2CCostNs(uint32_t bytes, bool read) {
+  uint64_t bits = bytes * 9 + (read ? 3 : 2);
+  return bits * 1000000000ULL / sim_i2c_clock_hz;
+}
+
+// Called with the lock held, returns the time the bus would be busy
+static uint32_t SimI2CRecord(uint8_t addr, uint8_t reg, bool read, const uint8_t *data, uint32_t length,
+                             uint32_t bytes_on_bus) {
+  SimI2CTransaction transaction;
+  transaction.addr = addr;
+  transaction.reg = reg;
+  transaction.read = read;
+  transaction.data.assign(data, data + length);
+  transaction.cost_ns = SimI2CCostNs(bytes_on_bus, read);
+  sim_i2c_trace.push_back(transaction);
+  return sim_i2c_blocking ? transaction.cost_ns : 0;
+}
+
+static void SimI2CWait(uint32_t busy_ns) {
+  if (busy_ns != 0) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(busy_ns));
+  }
+}
+
+int SimI2CSetup(uint8_t addr) {
+  if (addr >= SIM_I2C_ADDR_COUNT) { return -1; }
+  return SIM_I2C_FD_BASE + addr;
+}
+
+int SimI2CWrite(int fd, uint8_t data) {
+  uint8_t addr;
+  if (!SimI2CAddr(fd, addr)) { return -1; }
+  uint32_t busy_ns;
+  {
+    std::lock_guard<std::mutex> lock(sim_i2c_mutex);
+    busy_ns = SimI2CRecord(addr, data, false, nullptr, 0, 2);
+  }
+  SimI2CWait(busy_ns);
+  return 0;
+}
+
+bool SimI2CWriteBurst(int fd, uint8_t reg, const uint8_t *data, uint32_t length) {
+  uint8_t addr;
+  if (!SimI2CAddr(fd, addr)) { return false; }
+  uint32_t busy_ns;
+  {
+    std::lock_guard<std::mutex> lock(sim_i2c_mutex);
+    if (sim_i2c_fail_count != 0 && addr == sim_i2c_fail_addr &&
+        (uint8_t)(sim_i2c_fail_reg - reg) < length) {
+      sim_i2c_fail_count--;
+      return false;
+    }
+    // Auto-increment wraps at the end of the register space
+    for (uint32_t i = 0; i < length; i++) {
+      sim_i2c_registers[addr][(reg + i) % SIM_I2C_REGISTER_COUNT] = data[i];
+    }
+    busy_ns = SimI2CRecord(addr, reg, false, data, length, 2 + length);
+  }
+  SimI2CWait(busy_ns);
+  return true;
+}
+
+int SimI2CWriteReg8(int fd, uint8_t reg, uint8_t value) {
+  return SimI2CWriteBurst(fd, reg, &value, 1) ? 0 : -1;
+}
+
+// Low byte first, as wiringPi sends it
+int SimI2CWriteReg16(int fd, uint8_t reg, uint16_t value) {
+  uint8_t data[2] = {(uint8_t)(value & 0xFF), (uint8_t)(value >> 8)};
+  return SimI2CWriteBurst(fd, reg, data, 2) ? 0 : -1;
+}
+
+int SimI2CReadReg8(int fd, uint8_t reg) {
+  uint8_t addr;
+  if (!SimI2CAddr(fd, addr)) { return -1; }
+  uint32_t busy_ns;
+  uint8_t value;
+  {
+    std::lock_guard<std::mutex> lock(sim_i2c_mutex);
+    value = sim_i2c_registers[addr][reg];
+    busy_ns = SimI2CRecord(addr, reg, true, &value, 1, 4);
+  }
+  SimI2CWait(busy_ns);
+  return value;
+}
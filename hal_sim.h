@@ -0,0 +1,55 @@
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include <stdint.h>
+#include <vector>
+#include "hal.h"
+
+// Simulated backend. Pins start high, as with the pull ups and no button
+// pressed. Every I2C address answers and keeps its registers, each transaction
+// is added to the trace with what it would cost on the bus
+
+// One I2C transaction, for a single byte write reg is the byte and data is empty
+struct SimI2CTransaction {
+  uint8_t addr;
+  uint8_t reg;
+  bool read;
+  std::vector<uint8_t> data;
+  uint32_t cost_ns;   // Bus time at the simulated clock
+};
+
+// Standard mode, the Pi's default
+#define SIM_I2C_DEFAULT_CLOCK_HZ 100000
+
+// Test side
+// Sets the pin's level as if the button moved at timestamp_ns, the pin's ISR
+// runs on the caller's thread if the level changed. One thread per pin
+void SimGpioSetLevel(int pin, int level, uint64_t timestamp_ns);
+// All pins high, ISRs and I2C registers cleared, trace emptied
+void SimReset();
+std::vector<SimI2CTransaction> SimI2CGetTrace();
+void SimI2CClearTrace();
+// Sum of the cost of the transactions in the trace
+uint64_t SimI2CGetBusTimeNs();
+void SimI2CSetClock(uint32_t hz);
+// Transactions take their bus time, to profile the LED worker as on the Pi
+void SimI2CSetBlocking(bool blocking);
+uint8_t SimI2CGetRegister(uint8_t addr, uint8_t reg);
+// The next count writes to addr that cover reg fail without reaching the
+// device, as when it's busy or NAKs
+void SimI2CFailWrites(uint8_t addr, uint8_t reg, uint32_t count);
+
+// Backend, called through hal.h
+int SimGpioSetup();
+void SimGpioInputPullUp(int pin);
+int SimGpioRead(int pin);
+int SimGpioIsr(int pin, HalIsr isr);
+uint64_t SimGpioEdgeTimeNs(int pin);
+int SimI2CSetup(uint8_t addr);
+int SimI2CWrite(int fd, uint8_t data);
+int SimI2CWriteReg8(int fd, uint8_t reg, uint8_t value);
+int SimI2CWriteReg16(int fd, uint8_t reg, uint16_t value);
+int SimI2CReadReg8(int fd, uint8_t reg);
+bool SimI2CWriteBurst(int fd, uint8_t reg, const uint8_t *data, uint32_t length);
+
+#endif // HAL_SIM_H
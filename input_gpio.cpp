@@ -1,74 +1,92 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <wiringPi.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <chrono>
 #include <thread>
 #include "util.h"
+#include "hal.h"
 #include "input_gpio.h"
+#include "latency_histogram.h"
+#include "rt_log.h"
 #include "rpi_io_to_app_map.h"
 
 InputGpio* InputGpio::instance = nullptr;
 
-static void InputProcessedEventToText(InputProcessedEvent event) {
-    if (event == InputProcessedEvent::kNo) {
-      std::cout << "No Event";
-    }
+#if !defined(NDEBUG) && defined(DTEST_GPIO_VERBOSE)
+static const char* InputProcessedEventToText(InputProcessedEvent event) {
     if (event == InputProcessedEvent::kDown) {
-      std::cout << "Down Event";
+      return "Down Event";
     }
     if (event == InputProcessedEvent::kUp) {
-      std::cout << "Up Event";
+      return "Up Event";
     }
     if (event == InputProcessedEvent::kDoubleDown) {
-      std::cout << "DoubleDown Event";
+      return "DoubleDown Event";
     }
     if (event == InputProcessedEvent::kShortPulse) {
-      std::cout << "ShortPulse Event";
+      return "ShortPulse Event";
     }
     if (event == InputProcessedEvent::kLongPulse) {
-      std::cout << "LongPulse Event";
+      return "LongPulse Event";
     }
+    return "No Event";
 }
+#endif
 
-// Static Methods
-void InputGpio::EnqueueInputDownEvent(uint32_t input_number) {
-  processed_event_queue[++processed_event_counter].event = InputProcessedEvent::kDown;
-  processed_event_queue[processed_event_counter].wpi_pin = input_number;
-}
-
-void InputGpio::EnqueueInputUpEvent(uint32_t input_number) {
-  processed_event_queue[++processed_event_counter].event = InputProcessedEvent::kUp;
-  processed_event_queue[processed_event_counter].wpi_pin = input_number;
+// Called from the ISR threads, one per pin
+void InputGpio::EnqueueInputEvent(InputProcessedEvent event, uint32_t input_number, uint64_t timestamp_ns) {
+  ProcessedEvent e;
+  e.event = event;
+  e.wpi_pin = input_number;
+  e.timestamp_ns = timestamp_ns;
+  if (!event_queue_.Push(e)) {
+    dropped_events_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  // Wake the control thread, write is safe from any thread
+  uint64_t one = 1;
+  if (write(event_fd_, &one, sizeof(one)) != sizeof(one)) {
+    RT_LOG("Error signalling GPIO event");
+  }
 }
 
+// Each pin is debounced on its own, presses on different buttons don't
+// interfere
 void InputGpio::GpioIsrProcessor(uint32_t input_number) {
-  static int last_read = -1;
-  int current_read = digitalRead(input_number);
-  if (last_read == current_read) {
+  if (input_number >= GPIO_PIN_COUNT) {
+    return;
+  }
+  uint64_t now_ns = HalGpioEdgeTimeNs(input_number);
+  PinDebounce &pin = debounce_[input_number];
+  int current_read = HalGpioRead(input_number);
+  if (pin.last_read == current_read) {
     return;
   }
   // Debounce
-  struct timeval current;
-  struct timeval diff;
-  static struct timeval last_gpio = (struct timeval){0};
-  gettimeofday(&current, NULL);
-  timersub(&current, &last_gpio, &diff);
-  last_gpio = current;
-  if (diff.tv_usec < DEBOUNCE_TIME_US) {
+  uint64_t diff_ns = now_ns - pin.last_edge_ns;
+  pin.last_edge_ns = now_ns;
+  if (diff_ns < DEBOUNCE_TIME_US * 1000ULL) {
     return;
   }
 
-  if (current_read == LOW) {
-    InputGpio::EnqueueInputDownEvent(input_number);
+  if (current_read == HAL_LOW) {
+    EnqueueInputEvent(InputProcessedEvent::kDown, input_number, now_ns);
   } else {
-    InputGpio::EnqueueInputUpEvent(input_number);
+    EnqueueInputEvent(InputProcessedEvent::kUp, input_number, now_ns);
   }
-  last_read = current_read;
+  pin.last_read = current_read;
 }
 
+#ifdef DTEST_GPIO_INJECT
+void InputGpio::InjectEvent(InputProcessedEvent event, int wpi_pin, uint64_t timestamp_ns) {
+  EnqueueInputEvent(event, wpi_pin, timestamp_ns);
+}
+#endif
+
 // Sadly, wiringPi doesn't have a means of notifying the user which GPIO has encountered
 // an interrupt. So we have to create unique functions for each GPIO, instead of one
 // generic handler
@@ -221,65 +239,143 @@ void InputGpio::Gpio_23_IsrHandler() {
 
 InputGpio::InputGpio() {
   instance = this;
+  dropped_events_.store(0);
+  event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd_ < 0) {
+    std::cout << "Error creating GPIO eventfd" << std::endl;
+  }
+  for (auto &pin : debounce_) {
+    pin.last_read = -1;
+    pin.last_edge_ns = 0;
+  }
   Reset();
 }
 
+InputGpio::~InputGpio() {
+  if (instance == this) {
+    instance = nullptr;
+  }
+  if (event_fd_ >= 0) {
+    close(event_fd_);
+  }
+}
+
+// Discards queued events, call from the thread handling events
 void InputGpio::Reset() {
-  processed_event_counter = 0;
-  for (auto &e : processed_event_queue) {
-    e.event = InputProcessedEvent::kNo;
-    e.wpi_pin = 0;
+  ProcessedEvent e;
+  while (event_queue_.Pop(e)) {}
+  for (auto &pin : gestures_) {
+    pin.held = false;
+    pin.long_sent = false;
+    pin.down_ns = 0;
+    pin.last_down_ns = 0;
   }
   last_event = InputProcessedEvent::kNo;
+  last_event_ns = 0;
   last_group = MAX_GROUP_COUNT;
   last_track = MAX_TRACK_COUNT;
   last_event_for_track = false;
 }
 
+static const uint64_t kDoubleDownNs = DOUBLE_DOWN_TIME_S * 1000000000ULL;
+static const uint64_t kLongPulseNs = LONG_PULSE_TIME_S * 1000000000ULL + LONG_PULSE_TIME_US * 1000ULL;
+
 // Events of concern for the state machine are
-// Down, Double Down (2 downs within 1s), and Long Pulse (up 1s after down)
-void InputGpio::ProcessedEventQueueUpdate() {
-  struct timeval current;
-  struct timeval diff;
-  static struct timeval last_down = (struct timeval){0};
-
-  gettimeofday(&current, NULL);
-
-  if (processed_event_queue[processed_event_counter].event == InputProcessedEvent::kDown) {
-    if (last_down.tv_sec != 0 && last_down.tv_usec != 0) {
-      // check if double-down -- two downs within limit, insert
-      // This will cause two fast transitions
-      timersub(&current, &last_down, &diff);
-      if (diff.tv_sec < DOUBLE_DOWN_TIME_S) {
-        processed_event_queue[processed_event_counter].event = InputProcessedEvent::kDoubleDown;
-      }
+// Down, Double Down (2 downs within 1s), and Long Pulse (held 1.5s)
+// Times are those taken in the ISR, not when the event is handled
+void InputGpio::ClassifyEvent(ProcessedEvent &e) {
+  if (e.wpi_pin < 0 || e.wpi_pin >= GPIO_PIN_COUNT) {
+    return;
+  }
+  PinGesture &pin = gestures_[e.wpi_pin];
+  if (e.event == InputProcessedEvent::kDown) {
+    pin.held = true;
+    pin.long_sent = false;
+    pin.down_ns = e.timestamp_ns;
+    // The first down has already been acted on, the double down refines it
+    if (pin.last_down_ns != 0 && e.timestamp_ns - pin.last_down_ns < kDoubleDownNs) {
+      e.event = InputProcessedEvent::kDoubleDown;
+      pin.last_down_ns = 0;
+    } else {
+      pin.last_down_ns = e.timestamp_ns;
     }
-    last_down = current;
     return;
   }
-  // With up events we want to replace the UP with a Pulse event
-  // Currently, only the Long Pulse is used
-  // The downs should trigger the main action with the exception of a long
-  // awaited up --> a long pulse
-  if (processed_event_queue[processed_event_counter].event == InputProcessedEvent::kUp) {
-    // Received Up - check if PB was held down for a long pulse
-    timersub(&current, &last_down, &diff);
-    if (diff.tv_sec > LONG_PULSE_TIME_S || ( diff.tv_sec == LONG_PULSE_TIME_S && diff.tv_usec > LONG_PULSE_TIME_US)) {
-      processed_event_queue[processed_event_counter].event = InputProcessedEvent::kLongPulse;
+  if (e.event == InputProcessedEvent::kUp) {
+    bool was_held = pin.held;
+    pin.held = false;
+    // Long pulse already sent while the button was down
+    if (pin.long_sent) {
+      return;
+    }
+    if (was_held && e.timestamp_ns - pin.down_ns > kLongPulseNs) {
+      e.event = InputProcessedEvent::kLongPulse;
     } else {
-      processed_event_queue[processed_event_counter].event = InputProcessedEvent::kShortPulse;
+      e.event = InputProcessedEvent::kShortPulse;
+    }
+  }
+}
+
+// A button held past the long pulse time, reported without waiting for the up
+bool InputGpio::PollLongPress(uint64_t now_ns, ProcessedEvent &e) {
+  for (uint32_t wpi_pin = 0; wpi_pin < GPIO_PIN_COUNT; wpi_pin++) {
+    PinGesture &pin = gestures_[wpi_pin];
+    if (pin.held && !pin.long_sent && now_ns - pin.down_ns > kLongPulseNs) {
+      pin.long_sent = true;
+      e.event = InputProcessedEvent::kLongPulse;
+      e.wpi_pin = wpi_pin;
+      e.timestamp_ns = pin.down_ns + kLongPulseNs;
+      return true;
     }
   }
+  return false;
+}
+
+// ns until the first held button reaches the long pulse time, -1 if none is held
+int64_t InputGpio::NextLongPressNs(uint64_t now_ns) {
+  int64_t next_ns = -1;
+  for (auto &pin : gestures_) {
+    if (!pin.held || pin.long_sent) { continue; }
+    uint64_t deadline = pin.down_ns + kLongPulseNs;
+    int64_t wait_ns = deadline > now_ns ? (int64_t)(deadline - now_ns) : 0;
+    if (next_ns < 0 || wait_ns < next_ns) {
+      next_ns = wait_ns;
+    }
+  }
+  return next_ns;
+}
+
+bool InputGpio::WaitForEvents(int timeout_ms) {
+  int64_t long_press_ns = NextLongPressNs(MonotonicNowNs());
+  if (long_press_ns >= 0) {
+    // Round up so the long pulse is due when poll returns
+    int long_press_ms = (int)((long_press_ns + 999999) / 1000000) + 1;
+    if (timeout_ms < 0 || long_press_ms < timeout_ms) {
+      timeout_ms = long_press_ms;
+    }
+  }
+  struct pollfd pfd;
+  pfd.fd = event_fd_;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  int ready = poll(&pfd, 1, timeout_ms);
+  if (ready <= 0) {
+    return long_press_ns >= 0 && NextLongPressNs(MonotonicNowNs()) == 0;
+  }
+  // Reset the count, every queued event is taken by ProcessAndHandleInputEvents
+  uint64_t count;
+  if (read(event_fd_, &count, sizeof(count)) != sizeof(count)) {
+    return false;
+  }
+  return true;
 }
 
 bool InputGpio::ConfigureWiringPiPins() {
   for (int i = 0; i < 16; i++) {
-    pinMode(track_to_pin.at(i).wiring_pi, INPUT);
-    pullUpDnControl(track_to_pin.at(i).wiring_pi, PUD_UP);
+    HalGpioInputPullUp(track_to_pin.at(i).wiring_pi);
   }
   for (int i = 0; i < 8; i++) {
-    pinMode(group_to_pin.at(i).wiring_pi, INPUT);
-    pullUpDnControl(group_to_pin.at(i).wiring_pi, PUD_UP);
+    HalGpioInputPullUp(group_to_pin.at(i).wiring_pi);
   }
   return true;
 }
@@ -288,82 +384,82 @@ bool InputGpio::AssignWiringPiISRs() {
   /* Tracks - index of track_to_pin starts at 0 and represents Track 0
    * index 1 represets Track 1, etc..
    */
-  if (wiringPiISR(track_to_pin.at(0).wiring_pi, INT_EDGE_BOTH, &Gpio_0_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(0).wiring_pi, &Gpio_0_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 0" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(1).wiring_pi, INT_EDGE_BOTH, &Gpio_1_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(1).wiring_pi, &Gpio_1_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 1" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(2).wiring_pi, INT_EDGE_BOTH, &Gpio_2_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(2).wiring_pi, &Gpio_2_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 2" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(3).wiring_pi, INT_EDGE_BOTH, &Gpio_3_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(3).wiring_pi, &Gpio_3_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 3" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(4).wiring_pi, INT_EDGE_BOTH, &Gpio_4_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(4).wiring_pi, &Gpio_4_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 4" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(5).wiring_pi, INT_EDGE_BOTH, &Gpio_5_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(5).wiring_pi, &Gpio_5_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 5" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(6).wiring_pi, INT_EDGE_BOTH, &Gpio_6_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(6).wiring_pi, &Gpio_6_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 6" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(7).wiring_pi, INT_EDGE_BOTH, &Gpio_7_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(7).wiring_pi, &Gpio_7_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 7" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(8).wiring_pi, INT_EDGE_BOTH, &Gpio_8_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(8).wiring_pi, &Gpio_8_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 8" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(9).wiring_pi, INT_EDGE_BOTH, &Gpio_9_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(9).wiring_pi, &Gpio_9_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 9" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(10).wiring_pi, INT_EDGE_BOTH, &Gpio_10_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(10).wiring_pi, &Gpio_10_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 10" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(11).wiring_pi, INT_EDGE_BOTH, &Gpio_11_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(11).wiring_pi, &Gpio_11_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 11" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(12).wiring_pi, INT_EDGE_BOTH, &Gpio_12_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(12).wiring_pi, &Gpio_12_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 12" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(13).wiring_pi, INT_EDGE_BOTH, &Gpio_13_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(13).wiring_pi, &Gpio_13_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 13" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(14).wiring_pi, INT_EDGE_BOTH, &Gpio_14_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(14).wiring_pi, &Gpio_14_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 14" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(track_to_pin.at(15).wiring_pi, INT_EDGE_BOTH, &Gpio_15_IsrHandler) < 0) {
+  if (HalGpioIsr(track_to_pin.at(15).wiring_pi, &Gpio_15_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 15" << std::endl;
     return false;
   }
@@ -372,37 +468,37 @@ bool InputGpio::AssignWiringPiISRs() {
   /* Groups - index of group_to_pin starts at 0 and represets Group 0
    * index 1 represents Group 1, etc..
    */
-  if (wiringPiISR(group_to_pin.at(0).wiring_pi, INT_EDGE_BOTH, &Gpio_16_IsrHandler) < 0) {
+  if (HalGpioIsr(group_to_pin.at(0).wiring_pi, &Gpio_16_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 16" << std::endl;
     return false;
   }
-  if (wiringPiISR(group_to_pin.at(1).wiring_pi, INT_EDGE_BOTH, &Gpio_17_IsrHandler) < 0) {
+  if (HalGpioIsr(group_to_pin.at(1).wiring_pi, &Gpio_17_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 17" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(group_to_pin.at(2).wiring_pi, INT_EDGE_BOTH, &Gpio_18_IsrHandler) < 0) {
+  if (HalGpioIsr(group_to_pin.at(2).wiring_pi, &Gpio_18_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 18" << std::endl;
     return false;
   }
-  if (wiringPiISR(group_to_pin.at(3).wiring_pi, INT_EDGE_BOTH, &Gpio_19_IsrHandler) < 0) {
+  if (HalGpioIsr(group_to_pin.at(3).wiring_pi, &Gpio_19_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 19" << std::endl;
     return false;
   }
-  if (wiringPiISR(group_to_pin.at(4).wiring_pi, INT_EDGE_BOTH, &Gpio_20_IsrHandler) < 0) {
+  if (HalGpioIsr(group_to_pin.at(4).wiring_pi, &Gpio_20_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 20" << std::endl;
     return false;
   }
-  if (wiringPiISR(group_to_pin.at(5).wiring_pi, INT_EDGE_BOTH, &Gpio_21_IsrHandler) < 0) {
+  if (HalGpioIsr(group_to_pin.at(5).wiring_pi, &Gpio_21_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 21" << std::endl;
     return false;
   }
 
-  if (wiringPiISR(group_to_pin.at(6).wiring_pi, INT_EDGE_BOTH, &Gpio_22_IsrHandler) < 0) {
+  if (HalGpioIsr(group_to_pin.at(6).wiring_pi, &Gpio_22_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 22" << std::endl;
     return false;
   }
-  if (wiringPiISR(group_to_pin.at(7).wiring_pi, INT_EDGE_BOTH, &Gpio_23_IsrHandler) < 0) {
+  if (HalGpioIsr(group_to_pin.at(7).wiring_pi, &Gpio_23_IsrHandler) < 0) {
     std::cout << "Unable to setup ISR PB 23" << std::endl;
     return false;
   }
@@ -411,7 +507,7 @@ bool InputGpio::AssignWiringPiISRs() {
 }
 
 bool InputGpio::InitializeWiringPiGpio() {
-  wiringPiSetup();
+  HalGpioSetup();
   if (!ConfigureWiringPiPins()) {
     std::cout << "Error intializing WiringPi - Pin Configuration" << std::endl;
     return false;
@@ -424,61 +520,47 @@ bool InputGpio::InitializeWiringPiGpio() {
 }
 
 bool InputGpio::ProcessAndHandleInputEvents() {
-  if (processed_event_counter == 0) {return false;}
-
-  if (processed_event_counter > 1) {
-    std::cout << "***** MORE THAN ONE EVENT: " << processed_event_counter << std::endl;
-    for (int i = processed_event_counter; i > 0; i--) {
-      std::cout << "    " << processed_event_queue[i].wpi_pin;
-      std::cout << ", ";
-      InputProcessedEventToText(processed_event_queue[i].event);
-      std::cout << std::endl;
-    }
+  struct ProcessedEvent e;
+  if (event_queue_.Pop(e)) {
+    // process events - updating as needed
+    ClassifyEvent(e);
+  } else if (!PollLongPress(MonotonicNowNs(), e)) {
+    return false;
   }
+  uint32_t track = 0;
+  uint32_t group = 0;
 
-  while (processed_event_counter > 0) {
-    // process events - updating as needed
-    ProcessedEventQueueUpdate();
-    struct ProcessedEvent e;
-    e.wpi_pin = processed_event_queue[processed_event_counter].wpi_pin;
-    e.event = processed_event_queue[processed_event_counter].event;
-    uint32_t track = 0;
-    uint32_t group = 0;
-
-    //TODO When integrating, replace 16 and 8 with defines from headers for each
-    for (track = 0; track < 16; track++) {
-      if (e.wpi_pin == track_to_pin.at(track).wiring_pi) {
-	break;
-      }
+  //TODO When integrating, replace 16 and 8 with defines from headers for each
+  for (track = 0; track < 16; track++) {
+    if (e.wpi_pin == track_to_pin.at(track).wiring_pi) {
+      break;
     }
-    if (track < 16) {
+  }
+  if (track < 16) {
 #ifdef DTEST_GPIO_VERBOSE
-      std::cout << "ProcessAndHandleInputEvents() - track: " << track << " had event: ";
-      InputProcessedEventToText(e.event);
-      std::cout << std::endl;
+    RT_LOG("ProcessAndHandleInputEvents() - track: %u had event: %s", track,
+           InputProcessedEventToText(e.event));
 #endif
-      last_event_for_track = true;
-      last_track = track;
-    }
-    if (track == 16) {
-      for (group = 0; group < 8; group++) {
-        if (e.wpi_pin == group_to_pin.at(group).wiring_pi) {
-          break;
-        }
-      }
-      if (group < 8) {
-  #ifdef DTEST_GPIO_VERBOSE
-        std::cout << "ProcessAndHandleInputEvents() - group: " << group << " had event: ";
-        InputProcessedEventToText(e.event);
-        std::cout << std::endl;
-  #endif
-        last_event_for_track = false;
-        last_group = group;
+    last_event_for_track = true;
+    last_track = track;
+  }
+  if (track == 16) {
+    for (group = 0; group < 8; group++) {
+      if (e.wpi_pin == group_to_pin.at(group).wiring_pi) {
+        break;
       }
     }
-    last_event = e.event;
-    processed_event_counter--;
+    if (group < 8) {
+#ifdef DTEST_GPIO_VERBOSE
+      RT_LOG("ProcessAndHandleInputEvents() - group: %u had event: %s", group,
+             InputProcessedEventToText(e.event));
+#endif
+      last_event_for_track = false;
+      last_group = group;
+    }
   }
+  last_event = e.event;
+  last_event_ns = e.timestamp_ns;
   return true;
 }
 
@@ -513,3 +595,11 @@ int InputGpio::GetLastTrack() {
 int InputGpio::GetLastGroup() {
   return last_group;
 }
+
+uint64_t InputGpio::GetLastEventTime() {
+  return last_event_ns;
+}
+
+uint32_t InputGpio::GetDroppedEvents() {
+  return dropped_events_.load(std::memory_order_relaxed);
+}
@@ -1,6 +1,12 @@
 #ifndef INPUT_GPIO_H
 #define INPUT_GPIO_H
 
+#include <array>
+#include <atomic>
+#include <stdint.h>
+#include "mpsc_ring.h"
+#include "hal.h"
+
 #define DOUBLE_DOWN_TIME_S 1
 #define SHORT_PULSE_TIME_S 1
 #define SHORT_PULSE_TIME_US 500000
@@ -9,7 +15,8 @@
 #define LONG_PULSE_TIME_S 1
 #define LONG_PULSE_TIME_US 500000
 #define DEBOUNCE_TIME_US 20000
-#define MAX_EVENT_QUEUE_SIZE 8
+#define MAX_EVENT_QUEUE_SIZE 64
+#define GPIO_PIN_COUNT HAL_GPIO_PIN_COUNT
 
 enum class InputProcessedEvent {
   kNo = 0,
@@ -23,13 +30,37 @@ enum class InputProcessedEvent {
 struct ProcessedEvent {
   InputProcessedEvent event;
   int wpi_pin;
+  uint64_t timestamp_ns;   // CLOCK_MONOTONIC, taken in the ISR
+};
+
+// Debounce state of one pin, only touched by that pin's ISR thread
+struct PinDebounce {
+  int last_read;
+  uint64_t last_edge_ns;
+};
+
+// Gesture state of one pin, only touched by the thread handling events
+// Down is reported straight away, a second down within DOUBLE_DOWN_TIME_S is
+// reported as a DoubleDown and holding past the long pulse time reports a
+// LongPulse while the button is still down
+struct PinGesture {
+  bool held;
+  bool long_sent;
+  uint64_t down_ns;
+  uint64_t last_down_ns;  // 0 once a double down has used the press
 };
 
 class InputGpio {
   // Variables
-  volatile uint8_t processed_event_counter;
-  volatile ProcessedEvent processed_event_queue[MAX_EVENT_QUEUE_SIZE];
+  // Written by the ISR threads, read by the control thread
+  MpscRing<ProcessedEvent, MAX_EVENT_QUEUE_SIZE> event_queue_;
+  std::atomic<uint32_t> dropped_events_;
+  // Signalled for each queued event, the control thread blocks on it
+  int event_fd_;
+  std::array<PinDebounce, GPIO_PIN_COUNT> debounce_;
+  std::array<PinGesture, GPIO_PIN_COUNT> gestures_;
   InputProcessedEvent last_event;
+  uint64_t last_event_ns;
   uint16_t last_track;
   uint8_t last_group;
   bool last_event_for_track;
@@ -38,10 +69,11 @@ class InputGpio {
   bool ConfigureWiringPiPins();
   bool AssignWiringPiISRs();
 
-  void ProcessedEventQueueUpdate();
+  void ClassifyEvent(ProcessedEvent &e);
+  bool PollLongPress(uint64_t now_ns, ProcessedEvent &e);
+  int64_t NextLongPressNs(uint64_t now_ns);
 
-  void EnqueueInputDownEvent(uint32_t input_number);
-  void EnqueueInputUpEvent(uint32_t input_number);
+  void EnqueueInputEvent(InputProcessedEvent event, uint32_t input_number, uint64_t timestamp_ns);
   void GpioIsrProcessor(uint32_t input_number);
 
   // ISRs
@@ -74,10 +106,17 @@ class InputGpio {
 
   public:
   InputGpio();
+  ~InputGpio();
   static InputGpio* instance;
 
   bool InitializeWiringPiGpio();
+  // Takes the oldest queued event, or a long pulse of a button still held,
+  // false when there are none. Call until it returns false to handle every
+  // event in the order they happened
   bool ProcessAndHandleInputEvents();
+  // Blocks until an event is queued or a held button reaches the long pulse
+  // time, or timeout_ms passes (-1 waits for ever). Returns false on timeout
+  bool WaitForEvents(int timeout_ms);
   void Reset();
 
   bool LastEventWasDown();
@@ -88,6 +127,14 @@ class InputGpio {
   bool LastEventWasForTrack();
   int GetLastTrack();
   int GetLastGroup();
+  // CLOCK_MONOTONIC time of the last event, in ns
+  uint64_t GetLastEventTime();
+  // Events lost because the queue was full, since startup
+  uint32_t GetDroppedEvents();
+#ifdef DTEST_GPIO_INJECT
+  // Queue an edge as if the ISR had seen it
+  void InjectEvent(InputProcessedEvent event, int wpi_pin, uint64_t timestamp_ns);
+#endif
 };
 
 #endif //INPUT_GPIO_H
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <time.h>
+#include "latency_histogram.h"
+
+uint64_t MonotonicNowNs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+LatencyHistogram::LatencyHistogram() {
+  Reset();
+}
+
+void LatencyHistogram::Reset() {
+  buckets_.fill(0);
+  count_ = 0;
+  sum_ns_ = 0;
+  min_ns_ = UINT64_MAX;
+  max_ns_ = 0;
+}
+
+void LatencyHistogram::Add(uint64_t latency_ns) {
+  uint64_t us = latency_ns / 1000;
+  uint32_t bucket = 0;
+  while (us > 1 && bucket < LATENCY_BUCKET_COUNT - 1) {
+    us >>= 1;
+    bucket++;
+  }
+  buckets_[bucket]++;
+  count_++;
+  sum_ns_ += latency_ns;
+  if (latency_ns < min_ns_) { min_ns_ = latency_ns; }
+  if (latency_ns > max_ns_) { max_ns_ = latency_ns; }
+}
+
+uint32_t LatencyHistogram::GetCount() {
+  return count_;
+}
+
+uint64_t LatencyHistogram::GetPercentileUs(double percentile) {
+  if (count_ == 0) { return 0; }
+  uint64_t target = (uint64_t)(count_ * percentile / 100.0 + 0.5);
+  if (target == 0) { target = 1; }
+  uint64_t seen = 0;
+  for (uint32_t bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++) {
+    seen += buckets_[bucket];
+    if (seen >= target) {
+      return 2ULL << bucket;
+    }
+  }
+  return 2ULL << (LATENCY_BUCKET_COUNT - 1);
+}
+
+void LatencyHistogram::Print(const char *name) {
+  if (count_ == 0) {
+    std::cout << name << ": no samples" << std::endl;
+    return;
+  }
+  std::cout << name << ": count " << count_
+            << ", min " << min_ns_ / 1000 << "us"
+            << ", mean " << sum_ns_ / count_ / 1000 << "us"
+            << ", p50 <" << GetPercentileUs(50) << "us"
+            << ", p99 <" << GetPercentileUs(99) << "us"
+            << ", max " << max_ns_ / 1000 << "us" << std::endl;
+  for (uint32_t bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++) {
+    if (buckets_[bucket] == 0) { continue; }
+    std::cout << "    <" << (2ULL << bucket) << "us: " << buckets_[bucket] << std::endl;
+  }
+}
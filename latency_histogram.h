@@ -0,0 +1,32 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <stdint.h>
+
+// CLOCK_MONOTONIC in ns, the clock GPIO events are stamped with
+uint64_t MonotonicNowNs();
+
+// Power of two buckets in us, bucket 0 is under 2us and bucket n covers
+// [2^n, 2^(n+1)) us. Add doesn't allocate or lock, one thread only
+#define LATENCY_BUCKET_COUNT 24
+
+class LatencyHistogram {
+  std::array<uint32_t, LATENCY_BUCKET_COUNT> buckets_;
+  uint32_t count_;
+  uint64_t sum_ns_;
+  uint64_t min_ns_;
+  uint64_t max_ns_;
+
+  public:
+  LatencyHistogram();
+  void Reset();
+  void Add(uint64_t latency_ns);
+  uint32_t GetCount();
+  // Upper bound of the bucket holding the percentile, in us
+  uint64_t GetPercentileUs(double percentile);
+  // name: count, min, mean, p50, p99, max on one line then each used bucket
+  void Print(const char *name);
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,87 @@
+#include <fstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "memory_lock.h"
+#include "block_pool.h"
+
+// Locked bytes as the kernel sees them, from /proc/self/status
+static size_t ReadLockedBytes() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmLck:") == 0) {
+      return std::stoul(line.substr(6)) * 1024;
+    }
+  }
+  return 0;
+}
+
+MemoryLockReport LockAudioMemory() {
+  MemoryLockReport report = {0, 0, 0, false, false};
+  BlockPool &pool = BlockPool::getInstance();
+  char *storage = static_cast<char*>(pool.GetStorage());
+  size_t storage_bytes = pool.GetStorageBytes();
+  size_t os_page = (size_t)sysconf(_SC_PAGESIZE);
+
+#ifdef MADV_HUGEPAGE
+  // Fewer faults and TLB misses if the kernel has THP in madvise mode
+  if (storage != nullptr) {
+    report.huge_pages = madvise(storage, storage_bytes, MADV_HUGEPAGE) == 0;
+  }
+#endif
+
+  struct rlimit limit;
+  bool unlimited = true;
+  if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+    unlimited = false;
+    report.memlock_limit = limit.rlim_cur;
+  }
+
+  // MCL_FUTURE only when unlimited, with a limit later allocations
+  // (thread stacks, JACK buffers) would start to fail
+  int flags = MCL_CURRENT | (unlimited ? MCL_FUTURE : 0);
+  if (unlimited || report.memlock_limit > storage_bytes) {
+    report.process_locked = mlockall(flags) == 0;
+  }
+
+  if (storage != nullptr) {
+    if (report.process_locked) {
+      // mlockall faults in everything that is mapped
+      report.bytes_prefaulted = storage_bytes;
+    } else {
+      // Lock what the limit allows, leave room for what is already locked
+      size_t already = ReadLockedBytes();
+      size_t lockable = unlimited ? storage_bytes : 0;
+      if (!unlimited && report.memlock_limit > already) {
+        lockable = (report.memlock_limit - already) / os_page * os_page;
+      }
+      if (lockable > storage_bytes) { lockable = storage_bytes; }
+      if (lockable > 0 && mlock(storage, lockable) != 0) {
+        lockable = 0;
+      }
+      // mlock faults in what it locks. The rest stays lazy, writing it now
+      // would commit the whole pool and it could still be paged out
+      report.bytes_prefaulted = lockable;
+    }
+  }
+
+  report.bytes_locked = ReadLockedBytes();
+  return report;
+}
+
+void PrintMemoryLockReport(const MemoryLockReport &report) {
+  std::cout << "Memory lock: " << (report.process_locked ? "process locked" : "pool only")
+            << ", locked " << report.bytes_locked / 1024 << "KB"
+            << ", pre-faulted " << report.bytes_prefaulted / 1024 << "KB";
+  if (report.memlock_limit != 0) {
+    std::cout << ", RLIMIT_MEMLOCK " << report.memlock_limit / 1024 << "KB";
+  } else {
+    std::cout << ", RLIMIT_MEMLOCK unlimited";
+  }
+  std::cout << (report.huge_pages ? ", huge pages" : "") << std::endl;
+  if (!report.process_locked) {
+    std::cout << "Memory lock: raise RLIMIT_MEMLOCK (ulimit -l) to lock the whole process" << std::endl;
+  }
+}
@@ -0,0 +1,22 @@
+#ifndef MEMORY_LOCK_H
+#define MEMORY_LOCK_H
+
+#include <iostream>
+
+// Optional startup stage, run before audio processing is enabled, so recording
+// into new blocks never page faults inside the JACK callback.
+// Locks the whole process with mlockall when RLIMIT_MEMLOCK allows it, otherwise
+// locks as much of the BlockPool as the limit allows. Pages beyond the limit
+// are left to be faulted in on first use, as without this stage
+struct MemoryLockReport {
+  size_t memlock_limit;     // RLIMIT_MEMLOCK, 0 if unlimited
+  size_t bytes_locked;      // VmLck after locking
+  size_t bytes_prefaulted;  // BlockPool bytes faulted in, all of them locked
+  bool process_locked;      // mlockall succeeded
+  bool huge_pages;          // BlockPool advised to use transparent huge pages
+};
+
+MemoryLockReport LockAudioMemory();
+void PrintMemoryLockReport(const MemoryLockReport &report);
+
+#endif // MEMORY_LOCK_H
@@ -0,0 +1,54 @@
+#include <algorithm>
+#include <math.h>
+#include "mix_parameters.h"
+
+MixParameters::MixParameters() {
+  master_gain_ = 1.0f;
+  for (uint32_t t = 0; t < MAX_TRACK_COUNT; t++) {
+    track_gain_[t] = 1.0f;
+    track_pan_[t] = 0.0f;
+    Publish(t);
+  }
+}
+
+// Centre is -3dB on each side, cosf at hard right is a hair under 0
+void MixParameters::Publish(uint32_t track) {
+  float gain = track_gain_[track] * master_gain_;
+  float angle = (track_pan_[track] + 1.0f) * (float)M_PI / 4.0f;
+  channel_gain_[static_cast<uint32_t>(MixChannel::kMono)][track].store(gain, std::memory_order_relaxed);
+  channel_gain_[static_cast<uint32_t>(MixChannel::kLeft)][track].store(gain * std::max(cosf(angle), 0.0f),
+                                                                      std::memory_order_relaxed);
+  channel_gain_[static_cast<uint32_t>(MixChannel::kRight)][track].store(gain * sinf(angle),
+                                                                       std::memory_order_relaxed);
+}
+
+void MixParameters::SetTrackGain(uint32_t track, float gain) {
+  if (track >= MAX_TRACK_COUNT) { return; }
+  track_gain_[track] = std::max(gain, 0.0f);
+  Publish(track);
+}
+
+void MixParameters::SetTrackPan(uint32_t track, float pan) {
+  if (track >= MAX_TRACK_COUNT) { return; }
+  track_pan_[track] = std::min(std::max(pan, -1.0f), 1.0f);
+  Publish(track);
+}
+
+void MixParameters::SetMasterGain(float gain) {
+  master_gain_ = std::max(gain, 0.0f);
+  for (uint32_t t = 0; t < MAX_TRACK_COUNT; t++) {
+    Publish(t);
+  }
+}
+
+float MixParameters::GetTrackGain(uint32_t track) {
+  return track_gain_.at(track);
+}
+
+float MixParameters::GetTrackPan(uint32_t track) {
+  return track_pan_.at(track);
+}
+
+float MixParameters::GetMasterGain() {
+  return master_gain_;
+}
@@ -0,0 +1,51 @@
+#ifndef MIX_PARAMETERS_H
+#define MIX_PARAMETERS_H
+
+#include <array>
+#include <atomic>
+#include <stdint.h>
+
+#include "util.h"
+
+// Which output a TrackManager mixes, a stereo pair is one TrackManager per side
+enum class MixChannel : uint8_t {
+  kMono = 0,  // pan is ignored
+  kLeft,
+  kRight,
+  kCount
+};
+
+// Per-track gain and pan plus a master gain, set from the control thread and
+// read by the audio thread without locks. Each setter publishes one gain per
+// track per channel with pan and master already applied, so the audio thread
+// only loads a float per track. Pan is constant power, -1 is hard left.
+// Shared by the TrackManagers of a stereo pair
+class MixParameters {
+  // Control thread only
+  std::array<float, MAX_TRACK_COUNT> track_gain_;
+  std::array<float, MAX_TRACK_COUNT> track_pan_;
+  float master_gain_;
+
+  std::array<std::array<std::atomic<float>, MAX_TRACK_COUNT>,
+             static_cast<uint32_t>(MixChannel::kCount)> channel_gain_;
+
+  void Publish(uint32_t track);
+
+  public:
+  MixParameters();
+
+  // Control thread
+  void SetTrackGain(uint32_t track, float gain);
+  void SetTrackPan(uint32_t track, float pan);
+  void SetMasterGain(float gain);
+  float GetTrackGain(uint32_t track);
+  float GetTrackPan(uint32_t track);
+  float GetMasterGain();
+
+  // Audio thread
+  inline float GetChannelGain(MixChannel channel, uint32_t track) const {
+    return channel_gain_[static_cast<uint32_t>(channel)][track].load(std::memory_order_relaxed);
+  }
+};
+
+#endif // MIX_PARAMETERS_H
@@ -1,9 +1,598 @@
+#include <algorithm>
+#include <cstring>
+#include <math.h>
 #include "mixer.h"
 
-void MixBlocks(const DataBlock &block1, const DataBlock &block2, DataBlock &mix_down) {
-  for (uint32_t i = 0; i < block1.samples_.size(); i++) {
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define MIXER_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define MIXER_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define MIXER_HAVE_NEON
+#define MIXER_NEON_TARGET
+#include <arm_neon.h>
+#elif defined(__arm__) && (defined(__ARM_NEON) || (defined(__GNUC__) && !defined(__clang__) && defined(__ARM_FP)))
+// 32-bit Raspberry Pi OS builds for vfp, so only the NEON kernels are built
+// for NEON and they are only picked when the CPU reports it. AArch32 NEON
+// flushes denormals to zero, unlike VFP
+#define MIXER_HAVE_NEON
+#define MIXER_NEON_FLUSHES_DENORMALS
+#if defined(__ARM_NEON)
+#define MIXER_NEON_TARGET
+#else
+#define MIXER_NEON_TARGET __attribute__((target("fpu=neon")))
+#endif
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+/*
+ * Kernels
+ * All kernels must produce the same result as the scalar kernel, bit for bit,
+ * apart from 32-bit NEON where values within a denormal of zero may differ:
+ * for pairs the two sources are summed first, then added to the mixdown,
+ * for N-way mixes the sources are summed in order, for ramps the gain is
+ * gain + step * i then applied. mixer.cpp is built without fp contraction so
+ * the scalar kernels don't get fused multiply-adds the vector kernels lack
+ */
+
+static void MixSamplesScalar(const float *src1, const float *src2, float *mix_down, uint32_t nsamples) {
+  for (uint32_t i = 0; i < nsamples; i++) {
     // don't try compression or limiting, user can adjust volumes
-    mix_down.samples_.at(i) += block1.samples_.at(i) + block2.samples_.at(i);
+    mix_down[i] += src1[i] + src2[i];
+  }
+}
+
+// Sums sources in order into mix_down from start up to nsamples, vector kernels
+// use it for the remainder of a partial vector
+static void MixSourcesTail(const float *const *sources, uint32_t nsources, float *mix_down,
+                           uint32_t start, uint32_t nsamples) {
+  for (uint32_t i = start; i < nsamples; i++) {
+    float sum = sources[0][i];
+    for (uint32_t s = 1; s < nsources; s++) {
+      sum += sources[s][i];
+    }
+    mix_down[i] = sum;
+  }
+}
+
+static void MixSourcesScalar(const float *const *sources, uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  if (nsources == 0) {
+    std::fill(mix_down, mix_down + nsamples, 0.0f);
+    return;
+  }
+  MixSourcesTail(sources, nsources, mix_down, 0, nsamples);
+}
+
+static void MixSourcesGainTail(const float *const *sources, const float *gains, uint32_t nsources,
+                               float *mix_down, uint32_t start, uint32_t nsamples) {
+  for (uint32_t i = start; i < nsamples; i++) {
+    float sum = sources[0][i] * gains[0];
+    for (uint32_t s = 1; s < nsources; s++) {
+      sum += sources[s][i] * gains[s];
+    }
+    mix_down[i] = sum;
+  }
+}
+
+static void MixSourcesGainScalar(const float *const *sources, const float *gains,
+                                 uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  if (nsources == 0) {
+    std::fill(mix_down, mix_down + nsamples, 0.0f);
+    return;
+  }
+  MixSourcesGainTail(sources, gains, nsources, mix_down, 0, nsamples);
+}
+
+// Ramps from start up to nsamples, also the remainder of the vector kernels
+static void MixRampTail(const float *src, float *mix_down, float gain, float step,
+                        uint32_t start, uint32_t nsamples) {
+  for (uint32_t i = start; i < nsamples; i++) {
+    mix_down[i] += src[i] * (gain + step * (float)i);
+  }
+}
+
+static void GainRampTail(float *samples, float gain, float step, uint32_t start, uint32_t nsamples) {
+  for (uint32_t i = start; i < nsamples; i++) {
+    samples[i] *= gain + step * (float)i;
+  }
+}
+
+static void MixRampScalar(const float *src, float *mix_down, float gain, float step, uint32_t nsamples) {
+  MixRampTail(src, mix_down, gain, step, 0, nsamples);
+}
+
+static void GainRampScalar(float *samples, float gain, float step, uint32_t nsamples) {
+  GainRampTail(samples, gain, step, 0, nsamples);
+}
+
+#ifdef MIXER_HAVE_SSE2
+static void MixSamplesSse2(const float *src1, const float *src2, float *mix_down, uint32_t nsamples) {
+  uint32_t i = 0;
+  for (; i + 4 <= nsamples; i += 4) {
+    __m128 sum = _mm_add_ps(_mm_loadu_ps(src1 + i), _mm_loadu_ps(src2 + i));
+    _mm_storeu_ps(mix_down + i, _mm_add_ps(_mm_loadu_ps(mix_down + i), sum));
+  }
+  MixSamplesScalar(src1 + i, src2 + i, mix_down + i, nsamples - i);
+}
+
+static void MixSourcesSse2(const float *const *sources, uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  if (nsources == 0) {
+    MixSourcesScalar(sources, nsources, mix_down, nsamples);
+    return;
+  }
+  uint32_t i = 0;
+  for (; i + 4 <= nsamples; i += 4) {
+    __m128 sum = _mm_loadu_ps(sources[0] + i);
+    for (uint32_t s = 1; s < nsources; s++) {
+      sum = _mm_add_ps(sum, _mm_loadu_ps(sources[s] + i));
+    }
+    _mm_storeu_ps(mix_down + i, sum);
   }
-} 
+  MixSourcesTail(sources, nsources, mix_down, i, nsamples);
+}
 
+static void MixSourcesGainSse2(const float *const *sources, const float *gains,
+                               uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  if (nsources == 0) {
+    MixSourcesGainScalar(sources, gains, nsources, mix_down, nsamples);
+    return;
+  }
+  uint32_t i = 0;
+  for (; i + 4 <= nsamples; i += 4) {
+    __m128 sum = _mm_mul_ps(_mm_loadu_ps(sources[0] + i), _mm_set1_ps(gains[0]));
+    for (uint32_t s = 1; s < nsources; s++) {
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(sources[s] + i), _mm_set1_ps(gains[s])));
+    }
+    _mm_storeu_ps(mix_down + i, sum);
+  }
+  MixSourcesGainTail(sources, gains, nsources, mix_down, i, nsamples);
+}
+
+static void MixRampSse2(const float *src, float *mix_down, float gain, float step, uint32_t nsamples) {
+  const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+  const __m128 vgain = _mm_set1_ps(gain);
+  const __m128 vstep = _mm_set1_ps(step);
+  uint32_t i = 0;
+  for (; i + 4 <= nsamples; i += 4) {
+    __m128 g = _mm_add_ps(vgain, _mm_mul_ps(vstep, _mm_add_ps(_mm_set1_ps((float)i), lanes)));
+    __m128 scaled = _mm_mul_ps(_mm_loadu_ps(src + i), g);
+    _mm_storeu_ps(mix_down + i, _mm_add_ps(_mm_loadu_ps(mix_down + i), scaled));
+  }
+  MixRampTail(src, mix_down, gain, step, i, nsamples);
+}
+
+static void GainRampSse2(float *samples, float gain, float step, uint32_t nsamples) {
+  const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+  const __m128 vgain = _mm_set1_ps(gain);
+  const __m128 vstep = _mm_set1_ps(step);
+  uint32_t i = 0;
+  for (; i + 4 <= nsamples; i += 4) {
+    __m128 g = _mm_add_ps(vgain, _mm_mul_ps(vstep, _mm_add_ps(_mm_set1_ps((float)i), lanes)));
+    _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), g));
+  }
+  GainRampTail(samples, gain, step, i, nsamples);
+}
+#endif
+
+#ifdef MIXER_HAVE_AVX2
+__attribute__((target("avx2")))
+static void MixSamplesAvx2(const float *src1, const float *src2, float *mix_down, uint32_t nsamples) {
+  uint32_t i = 0;
+  for (; i + 8 <= nsamples; i += 8) {
+    __m256 sum = _mm256_add_ps(_mm256_loadu_ps(src1 + i), _mm256_loadu_ps(src2 + i));
+    _mm256_storeu_ps(mix_down + i, _mm256_add_ps(_mm256_loadu_ps(mix_down + i), sum));
+  }
+  MixSamplesScalar(src1 + i, src2 + i, mix_down + i, nsamples - i);
+}
+
+__attribute__((target("avx2")))
+static void MixSourcesAvx2(const float *const *sources, uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  if (nsources == 0) {
+    MixSourcesScalar(sources, nsources, mix_down, nsamples);
+    return;
+  }
+  uint32_t i = 0;
+  for (; i + 8 <= nsamples; i += 8) {
+    __m256 sum = _mm256_loadu_ps(sources[0] + i);
+    for (uint32_t s = 1; s < nsources; s++) {
+      sum = _mm256_add_ps(sum, _mm256_loadu_ps(sources[s] + i));
+    }
+    _mm256_storeu_ps(mix_down + i, sum);
+  }
+  MixSourcesTail(sources, nsources, mix_down, i, nsamples);
+}
+
+__attribute__((target("avx2")))
+static void MixSourcesGainAvx2(const float *const *sources, const float *gains,
+                               uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  if (nsources == 0) {
+    MixSourcesGainScalar(sources, gains, nsources, mix_down, nsamples);
+    return;
+  }
+  uint32_t i = 0;
+  for (; i + 8 <= nsamples; i += 8) {
+    __m256 sum = _mm256_mul_ps(_mm256_loadu_ps(sources[0] + i), _mm256_set1_ps(gains[0]));
+    for (uint32_t s = 1; s < nsources; s++) {
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(sources[s] + i), _mm256_set1_ps(gains[s])));
+    }
+    _mm256_storeu_ps(mix_down + i, sum);
+  }
+  MixSourcesGainTail(sources, gains, nsources, mix_down, i, nsamples);
+}
+
+__attribute__((target("avx2")))
+static void MixRampAvx2(const float *src, float *mix_down, float gain, float step, uint32_t nsamples) {
+  const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  const __m256 vgain = _mm256_set1_ps(gain);
+  const __m256 vstep = _mm256_set1_ps(step);
+  uint32_t i = 0;
+  for (; i + 8 <= nsamples; i += 8) {
+    __m256 g = _mm256_add_ps(vgain, _mm256_mul_ps(vstep, _mm256_add_ps(_mm256_set1_ps((float)i), lanes)));
+    __m256 scaled = _mm256_mul_ps(_mm256_loadu_ps(src + i), g);
+    _mm256_storeu_ps(mix_down + i, _mm256_add_ps(_mm256_loadu_ps(mix_down + i), scaled));
+  }
+  MixRampTail(src, mix_down, gain, step, i, nsamples);
+}
+
+__attribute__((target("avx2")))
+static void GainRampAvx2(float *samples, float gain, float step, uint32_t nsamples) {
+  const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  const __m256 vgain = _mm256_set1_ps(gain);
+  const __m256 vstep = _mm256_set1_ps(step);
+  uint32_t i = 0;
+  for (; i + 8 <= nsamples; i += 8) {
+    __m256 g = _mm256_add_ps(vgain, _mm256_mul_ps(vstep, _mm256_add_ps(_mm256_set1_ps((float)i), lanes)));
+    _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), g));
+  }
+  GainRampTail(samples, gain, step, i, nsamples);
+}
+#endif
+
+#ifdef MIXER_HAVE_NEON
+MIXER_NEON_TARGET
+static void MixSamplesNeon(const float *src1, const float *src2, float *mix_down, uint32_t nsamples) {
+  uint32_t i = 0;
+  for (; i + 4 <= nsamples; i += 4) {
+    float32x4_t sum = vaddq_f32(vld1q_f32(src1 + i), vld1q_f32(src2 + i));
+    vst1q_f32(mix_down + i, vaddq_f32(vld1q_f32(mix_down + i), sum));
+  }
+  MixSamplesScalar(src1 + i, src2 + i, mix_down + i, nsamples - i);
+}
+
+MIXER_NEON_TARGET
+static void MixSourcesNeon(const float *const *sources, uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  if (nsources == 0) {
+    MixSourcesScalar(sources, nsources, mix_down, nsamples);
+    return;
+  }
+  uint32_t i = 0;
+  for (; i + 4 <= nsamples; i += 4) {
+    float32x4_t sum = vld1q_f32(sources[0] + i);
+    for (uint32_t s = 1; s < nsources; s++) {
+      sum = vaddq_f32(sum, vld1q_f32(sources[s] + i));
+    }
+    vst1q_f32(mix_down + i, sum);
+  }
+  MixSourcesTail(sources, nsources, mix_down, i, nsamples);
+}
+
+// Separate multiply and add, vmlaq_f32 may be fused
+MIXER_NEON_TARGET
+static void MixSourcesGainNeon(const float *const *sources, const float *gains,
+                               uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  if (nsources == 0) {
+    MixSourcesGainScalar(sources, gains, nsources, mix_down, nsamples);
+    return;
+  }
+  uint32_t i = 0;
+  for (; i + 4 <= nsamples; i += 4) {
+    float32x4_t sum = vmulq_f32(vld1q_f32(sources[0] + i), vdupq_n_f32(gains[0]));
+    for (uint32_t s = 1; s < nsources; s++) {
+      sum = vaddq_f32(sum, vmulq_f32(vld1q_f32(sources[s] + i), vdupq_n_f32(gains[s])));
+    }
+    vst1q_f32(mix_down + i, sum);
+  }
+  MixSourcesGainTail(sources, gains, nsources, mix_down, i, nsamples);
+}
+
+MIXER_NEON_TARGET
+static void MixRampNeon(const float *src, float *mix_down, float gain, float step, uint32_t nsamples) {
+  const float lane_values[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+  const float32x4_t lanes = vld1q_f32(lane_values);
+  const float32x4_t vgain = vdupq_n_f32(gain);
+  const float32x4_t vstep = vdupq_n_f32(step);
+  uint32_t i = 0;
+  for (; i + 4 <= nsamples; i += 4) {
+    float32x4_t g = vaddq_f32(vgain, vmulq_f32(vstep, vaddq_f32(vdupq_n_f32((float)i), lanes)));
+    float32x4_t scaled = vmulq_f32(vld1q_f32(src + i), g);
+    vst1q_f32(mix_down + i, vaddq_f32(vld1q_f32(mix_down + i), scaled));
+  }
+  MixRampTail(src, mix_down, gain, step, i, nsamples);
+}
+
+MIXER_NEON_TARGET
+static void GainRampNeon(float *samples, float gain, float step, uint32_t nsamples) {
+  const float lane_values[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+  const float32x4_t lanes = vld1q_f32(lane_values);
+  const float32x4_t vgain = vdupq_n_f32(gain);
+  const float32x4_t vstep = vdupq_n_f32(step);
+  uint32_t i = 0;
+  for (; i + 4 <= nsamples; i += 4) {
+    float32x4_t g = vaddq_f32(vgain, vmulq_f32(vstep, vaddq_f32(vdupq_n_f32((float)i), lanes)));
+    vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), g));
+  }
+  GainRampTail(samples, gain, step, i, nsamples);
+}
+#endif
+
+/*
+ * Dispatch
+ */
+
+struct MixKernels {
+  MixKernel pair;
+  MixSourcesKernel sources;
+  MixSourcesGainKernel sources_gain;
+  MixRampKernel ramp;
+  GainRampKernel gain;
+};
+
+static void MixSamplesResolve(const float *src1, const float *src2, float *mix_down, uint32_t nsamples);
+static void MixSourcesResolve(const float *const *sources, uint32_t nsources, float *mix_down, uint32_t nsamples);
+static void MixSourcesGainResolve(const float *const *sources, const float *gains,
+                                  uint32_t nsources, float *mix_down, uint32_t nsamples);
+static void MixRampResolve(const float *src, float *mix_down, float gain, float step, uint32_t nsamples);
+static void GainRampResolve(float *samples, float gain, float step, uint32_t nsamples);
+
+static MixKernels mix_kernels = {MixSamplesResolve, MixSourcesResolve, MixSourcesGainResolve,
+                                 MixRampResolve, GainRampResolve};
+static MixKernelType mix_kernel_type = MixKernelType::kScalar;
+
+static MixKernels KernelsForType(MixKernelType type) {
+  switch (type) {
+    case MixKernelType::kScalar:
+      return {MixSamplesScalar, MixSourcesScalar, MixSourcesGainScalar, MixRampScalar, GainRampScalar};
+#ifdef MIXER_HAVE_SSE2
+    case MixKernelType::kSse2:
+      return {MixSamplesSse2, MixSourcesSse2, MixSourcesGainSse2, MixRampSse2, GainRampSse2};
+#endif
+#ifdef MIXER_HAVE_AVX2
+    case MixKernelType::kAvx2:
+      return {MixSamplesAvx2, MixSourcesAvx2, MixSourcesGainAvx2, MixRampAvx2, GainRampAvx2};
+#endif
+#ifdef MIXER_HAVE_NEON
+    case MixKernelType::kNeon:
+      return {MixSamplesNeon, MixSourcesNeon, MixSourcesGainNeon, MixRampNeon, GainRampNeon};
+#endif
+    default:
+      return {nullptr, nullptr, nullptr, nullptr, nullptr};
+  }
+}
+
+// First mix before MixerInit was called - select then carry on
+static void MixSamplesResolve(const float *src1, const float *src2, float *mix_down, uint32_t nsamples) {
+  MixerInit();
+  mix_kernels.pair(src1, src2, mix_down, nsamples);
+}
+
+static void MixSourcesResolve(const float *const *sources, uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  MixerInit();
+  mix_kernels.sources(sources, nsources, mix_down, nsamples);
+}
+
+static void MixSourcesGainResolve(const float *const *sources, const float *gains,
+                                  uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  MixerInit();
+  mix_kernels.sources_gain(sources, gains, nsources, mix_down, nsamples);
+}
+
+static void MixRampResolve(const float *src, float *mix_down, float gain, float step, uint32_t nsamples) {
+  MixerInit();
+  mix_kernels.ramp(src, mix_down, gain, step, nsamples);
+}
+
+static void GainRampResolve(float *samples, float gain, float step, uint32_t nsamples) {
+  MixerInit();
+  mix_kernels.gain(samples, gain, step, nsamples);
+}
+
+bool MixerIsKernelSupported(MixKernelType type) {
+  if (KernelsForType(type).pair == nullptr) { return false; }
+  switch (type) {
+#if defined(MIXER_HAVE_SSE2) || defined(MIXER_HAVE_AVX2)
+    case MixKernelType::kSse2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2");
+    case MixKernelType::kAvx2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+#ifdef MIXER_HAVE_NEON
+    case MixKernelType::kNeon:
+#if defined(__aarch64__)
+      return true; // mandatory on aarch64
+#else
+      return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#endif
+#endif
+    default:
+      return true;
+  }
+}
+
+// Largest difference allowed from flushing denormals, a few sources and gains
+// of a denormal, far below any audible level
+#define MIXER_DENORMAL_TOLERANCE 1.0e-36f
+
+static bool KernelFlushesDenormals(MixKernelType type) {
+#ifdef MIXER_NEON_FLUSHES_DENORMALS
+  return type == MixKernelType::kNeon;
+#else
+  return false;
+#endif
+}
+
+static bool SamplesMatch(const float *expected, const float *result, uint32_t nsamples, bool flushes_denormals) {
+  if (memcmp(expected, result, sizeof(float) * nsamples) == 0) { return true; }
+  if (!flushes_denormals) { return false; }
+  for (uint32_t i = 0; i < nsamples; i++) {
+    if (memcmp(&expected[i], &result[i], sizeof(float)) != 0 &&
+        !(fabsf(expected[i] - result[i]) <= MIXER_DENORMAL_TOLERANCE)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Deterministic pseudo random samples in the audio range, with lengths that
+// exercise the scalar tails of the vector kernels
+bool MixerVerifyKernel(MixKernelType type) {
+  if (!MixerIsKernelSupported(type)) { return false; }
+  MixKernels kernels = KernelsForType(type);
+  bool flushes_denormals = KernelFlushesDenormals(type);
+  const uint32_t lengths[] = {SAMPLES_PER_BLOCK, 1, 3, 7, 13, 64, SAMPLES_PER_BLOCK - 1};
+  std::array<float, SAMPLES_PER_BLOCK> src1, src2, expected, result;
+  const float *sources[] = {src1.data(), src2.data(), expected.data(), src1.data(), src2.data()};
+  uint32_t seed = 0x1234567;
+
+  for (uint32_t pass = 0; pass < 8; pass++) {
+    for (uint32_t i = 0; i < SAMPLES_PER_BLOCK; i++) {
+      seed = seed * 1664525 + 1013904223;
+      src1[i] = (int32_t)seed / 2147483648.0f;
+      seed = seed * 1664525 + 1013904223;
+      src2[i] = (int32_t)seed / 2147483648.0f;
+      seed = seed * 1664525 + 1013904223;
+      expected[i] = (int32_t)seed / 2147483648.0f * (pass + 1);
+    }
+    // a few edge values
+    src1[0] = -0.0f;
+    src2[1] = 1.0e30f;
+    src1[2] = -1.0e30f;
+    // denormals, alone, summed with each other and with normal values
+    src1[3] = 1.0e-40f;
+    src2[4] = -3.0e-39f;
+    src1[5] = 1.0e-40f;
+    src2[5] = 2.0e-40f;
+    expected[6] = 5.0e-41f;
+
+    uint32_t nsamples = lengths[pass % (sizeof(lengths) / sizeof(lengths[0]))];
+    uint32_t nsources = pass % (sizeof(sources) / sizeof(sources[0]) + 1);
+
+    std::array<float, SAMPLES_PER_BLOCK> scalar_mix, kernel_mix;
+    scalar_mix.fill(1.0f);
+    kernel_mix.fill(1.0f);
+    MixSourcesScalar(sources, nsources, scalar_mix.data(), nsamples);
+    kernels.sources(sources, nsources, kernel_mix.data(), nsamples);
+    if (!SamplesMatch(scalar_mix.data(), kernel_mix.data(), SAMPLES_PER_BLOCK, flushes_denormals)) {
+      return false;
+    }
+
+    // gains cutting, boosting and muting
+    const float gains[] = {0.5f, 1.0f, 0.0f, 2.0f, 0.25f};
+    scalar_mix.fill(1.0f);
+    kernel_mix.fill(1.0f);
+    MixSourcesGainScalar(sources, gains, nsources, scalar_mix.data(), nsamples);
+    kernels.sources_gain(sources, gains, nsources, kernel_mix.data(), nsamples);
+    if (!SamplesMatch(scalar_mix.data(), kernel_mix.data(), SAMPLES_PER_BLOCK, flushes_denormals)) {
+      return false;
+    }
+
+    result = expected;
+    MixSamplesScalar(src1.data(), src2.data(), expected.data(), nsamples);
+    kernels.pair(src1.data(), src2.data(), result.data(), nsamples);
+    if (!SamplesMatch(expected.data(), result.data(), SAMPLES_PER_BLOCK, flushes_denormals)) {
+      return false;
+    }
+
+    // fade in then fade out over the block
+    float step = (pass & 0x1 ? -1.0f : 1.0f) / nsamples;
+    float gain = pass & 0x1 ? 1.0f : 0.0f;
+    scalar_mix = expected;
+    kernel_mix = expected;
+    MixRampScalar(src1.data(), scalar_mix.data(), gain, step, nsamples);
+    kernels.ramp(src1.data(), kernel_mix.data(), gain, step, nsamples);
+    GainRampScalar(scalar_mix.data(), gain, step, nsamples);
+    kernels.gain(kernel_mix.data(), gain, step, nsamples);
+    if (!SamplesMatch(scalar_mix.data(), kernel_mix.data(), SAMPLES_PER_BLOCK, flushes_denormals)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MixerSelectKernel(MixKernelType type) {
+  if (!MixerVerifyKernel(type)) { return false; }
+  mix_kernels = KernelsForType(type);
+  mix_kernel_type = type;
+  return true;
+}
+
+// Fastest first
+void MixerInit() {
+  const MixKernelType preference[] = {
+    MixKernelType::kAvx2, MixKernelType::kNeon, MixKernelType::kSse2
+  };
+  for (const auto &type : preference) {
+    if (MixerSelectKernel(type)) {
+      return;
+    }
+  }
+  MixerSelectKernel(MixKernelType::kScalar);
+}
+
+MixKernelType MixerGetKernel() {
+  return mix_kernel_type;
+}
+
+const char* MixerGetKernelName(MixKernelType type) {
+  switch (type) {
+    case MixKernelType::kScalar:
+      return "scalar";
+    case MixKernelType::kSse2:
+      return "sse2";
+    case MixKernelType::kAvx2:
+      return "avx2";
+    case MixKernelType::kNeon:
+      return "neon";
+    default:
+      return "unknown";
+  }
+}
+
+/*
+ * Mix
+ */
+
+void MixSamples(const float *src1, const float *src2, float *mix_down, uint32_t nsamples) {
+  mix_kernels.pair(src1, src2, mix_down, nsamples);
+}
+
+void MixSources(const float *const *sources, uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  mix_kernels.sources(sources, nsources, mix_down, nsamples);
+}
+
+void MixSourcesGain(const float *const *sources, const float *gains,
+                    uint32_t nsources, float *mix_down, uint32_t nsamples) {
+  mix_kernels.sources_gain(sources, gains, nsources, mix_down, nsamples);
+}
+
+void MixSourceRamp(const float *src, float *mix_down, float gain, float step, uint32_t nsamples) {
+  mix_kernels.ramp(src, mix_down, gain, step, nsamples);
+}
+
+void ApplyGainRamp(float *samples, float gain, float step, uint32_t nsamples) {
+  mix_kernels.gain(samples, gain, step, nsamples);
+}
+
+void MixBlocks(const DataBlock &block1, const DataBlock &block2, DataBlock &mix_down) {
+  mix_kernels.pair(block1.samples_.data(), block2.samples_.data(), mix_down.samples_.data(),
+             SAMPLES_PER_BLOCK);
+}
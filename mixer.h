@@ -7,5 +7,49 @@
 
 #include "data_block.h"
 
+// Mix kernels work on raw sample pointers so the same kernel can be used for
+// full DataBlocks, partial blocks and buffers owned by the audio driver
+// mix_down[i] += src1[i] + src2[i]
+typedef void (*MixKernel)(const float *src1, const float *src2, float *mix_down, uint32_t nsamples);
+// N-way mix in a single pass over the output, overwrites mix_down
+// mix_down[i] = sources[0][i] + sources[1][i] + ... , silence if nsources is 0
+typedef void (*MixSourcesKernel)(const float *const *sources, uint32_t nsources, float *mix_down, uint32_t nsamples);
+// N-way mix with a gain per source, overwrites mix_down
+// mix_down[i] = sources[0][i] * gains[0] + sources[1][i] * gains[1] + ...
+typedef void (*MixSourcesGainKernel)(const float *const *sources, const float *gains,
+                                     uint32_t nsources, float *mix_down, uint32_t nsamples);
+// Gain ramps for fades, the gain of sample i is gain + step * i
+// mix_down[i] += src[i] * (gain + step * i)
+typedef void (*MixRampKernel)(const float *src, float *mix_down, float gain, float step, uint32_t nsamples);
+// samples[i] *= gain + step * i
+typedef void (*GainRampKernel)(float *samples, float gain, float step, uint32_t nsamples);
+
+enum class MixKernelType {
+  kScalar = 0,  // Portable fallback, always available
+  kSse2,        // x86 test machines
+  kAvx2,        // x86 test machines
+  kNeon,        // Raspberry Pi
+  kCount
+};
+
 void MixBlocks(const DataBlock &block1, const DataBlock &block2, DataBlock &mix_down);
+void MixSamples(const float *src1, const float *src2, float *mix_down, uint32_t nsamples);
+void MixSources(const float *const *sources, uint32_t nsources, float *mix_down, uint32_t nsamples);
+void MixSourcesGain(const float *const *sources, const float *gains,
+                    uint32_t nsources, float *mix_down, uint32_t nsamples);
+void MixSourceRamp(const float *src, float *mix_down, float gain, float step, uint32_t nsamples);
+void ApplyGainRamp(float *samples, float gain, float step, uint32_t nsamples);
+
+// Kernel selection - MixerInit picks the fastest kernel the CPU supports that
+// produces bit-for-bit the same output as the scalar kernel. Call once at startup,
+// if not called the first mix will do it
+void MixerInit();
+// Returns false if the CPU doesn't support the kernel or it failed verification
+bool MixerSelectKernel(MixKernelType type);
+bool MixerIsKernelSupported(MixKernelType type);
+// Compare a kernel against the scalar kernel over a set of test vectors
+bool MixerVerifyKernel(MixKernelType type);
+MixKernelType MixerGetKernel();
+const char* MixerGetKernelName(MixKernelType type);
+
 #endif // MIXER_H
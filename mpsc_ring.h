@@ -0,0 +1,69 @@
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <array>
+#include <atomic>
+
+// Lock-free bounded multi producer single consumer ring. Any number of threads
+// may Push, one thread may Pop, nothing blocks or allocates. Producers claim a
+// position with a compare-exchange on the write position and entries are
+// popped in the order their positions were claimed. Each cell's sequence says
+// whether it is free for the producer at that position or holds an entry for
+// the consumer.
+// Size must be a power of two, capacity is Size entries
+template <typename T, uint32_t Size>
+class MpscRing {
+  static_assert(Size != 0 && (Size & (Size - 1)) == 0, "Size must be a power of two");
+
+  struct Cell {
+    std::atomic<uint32_t> sequence;
+    T entry;
+  };
+  std::array<Cell, Size> cells_;
+  std::atomic<uint32_t> write_pos_;
+  uint32_t read_pos_;
+
+  public:
+  MpscRing() : write_pos_(0), read_pos_(0) {
+    for (uint32_t i = 0; i < Size; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Producer side, false when full
+  bool Push(const T &entry) {
+    uint32_t pos = write_pos_.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+      cell = &cells_[pos & (Size - 1)];
+      uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+      int32_t diff = (int32_t)(sequence - pos);
+      if (diff == 0) {
+        if (write_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = write_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->entry = entry;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side, false when empty or the next entry is still being written
+  bool Pop(T &entry) {
+    Cell &cell = cells_[read_pos_ & (Size - 1)];
+    if (cell.sequence.load(std::memory_order_acquire) != read_pos_ + 1) {
+      return false;
+    }
+    entry = cell.entry;
+    cell.sequence.store(read_pos_ + Size, std::memory_order_release);
+    read_pos_++;
+    return true;
+  }
+};
+
+#endif // MPSC_RING_H
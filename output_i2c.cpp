@@ -5,9 +5,9 @@
 #include <sys/time.h>
 #include <chrono>
 #include <thread>
-#include <wiringPi.h>
-#include <wiringPiI2C.h>
 #include "output_i2c.h"
+#include "hal.h"
+#include "rt_log.h"
 
 struct I2CAddrValue {
   uint8_t addr;
@@ -191,25 +191,21 @@ static const uint16_t alphafonttable[] = {
 
 static void displayOn(int fd) {
   int err = 0;
-  err = wiringPiI2CWrite(fd, HT16K33_ON);
+  err = HalI2CWrite(fd, HT16K33_ON);
   if (err < 0) {std::cout << "err:" << err << std::endl;}
-  wiringPiI2CWrite(fd, HT16K33_DISPLAYON);
-  wiringPiI2CWrite(fd, HT16K33_BRIGHTNESS | 0x0F);
+  HalI2CWrite(fd, HT16K33_DISPLAYON);
+  HalI2CWrite(fd, HT16K33_BRIGHTNESS | 0x0F);
 }
 /*
 static void displayOff(int fd)
 {
-  wiringPiI2CWrite(fd, HT16K33_DISPLAYOFF);
-  wiringPiI2CWrite(fd, HT16K33_STANDBY);
+  HalI2CWrite(fd, HT16K33_DISPLAYOFF);
+  HalI2CWrite(fd, HT16K33_STANDBY);
 }
 */
 static void writePos(int fd, uint8_t pos, uint8_t mask)
 {
-  wiringPiI2CWriteReg8(fd, pos * 2, mask);
-}
-
-static void writePos16(int fd, uint8_t pos, uint16_t mask) {
-  wiringPiI2CWriteReg16(fd, pos * 2, mask);
+  HalI2CWriteReg8(fd, pos * 2, mask);
 }
 
 static void displayClear(int fd) {
@@ -219,16 +215,30 @@ static void displayClear(int fd) {
 }
 
 // load array with chars using ' ' method
-static void display16(int fd, uint16_t *array) {
+void OutputI2C::SetDisplayChars(uint16_t *array) {
   for (uint8_t i = 0; i < 4; i++)
   {
     if (array[i] != 0) break;
     array[i] = 0x0000;
   }
-  writePos16(fd, 0, alphafonttable[array[0]]);
-  writePos16(fd, 1, alphafonttable[array[1]]);
-  writePos16(fd, 2, alphafonttable[array[2]]);
-  writePos16(fd, 3, alphafonttable[array[3]]);
+  // Display RAM holds each position as a 16 bit row, low byte first
+  for (uint8_t pos = 0; pos < 4; pos++) {
+    display_frame_.desired[pos * 2] = alphafonttable[array[pos]] & 0xFF;
+    display_frame_.desired[pos * 2 + 1] = alphafonttable[array[pos]] >> 8;
+  }
+}
+
+static const uint32_t kPendingTracks = 0xFFFF;
+static const uint32_t kPendingInGroup = 0x1 << 16;
+static const uint32_t kPendingDisplay = 0x1 << 17;
+
+static void InitFrame(I2CFrame &frame, uint8_t addr) {
+  frame.fd = -1;
+  frame.addr = addr;
+  frame.desired.fill(0);
+  frame.committed.fill(0);
+  frame.managed.fill(false);
+  frame.committed_valid = false;
 }
 
 OutputI2C::OutputI2C() {
@@ -236,25 +246,197 @@ OutputI2C::OutputI2C() {
   i2c_green_fd = -1;
   i2c_yellow_fd = -1;
   i2c_disp0_fd = -1;
+  InitFrame(red_frame_, EXP0_ADDR);
+  InitFrame(green_frame_, EXP1_ADDR);
+  InitFrame(yellow_frame_, EXP2_ADDR);
+  InitFrame(display_frame_, DISP0_ADDR);
+  for (uint8_t led = 0; led < i2c_sx1509_led_ton.size(); led++) {
+    for (I2CFrame *frame : {&red_frame_, &green_frame_, &yellow_frame_}) {
+      frame->managed[i2c_sx1509_led_ton.at(led)] = true;
+      frame->managed[i2c_sx1509_led_toff.at(led)] = true;
+      frame->managed[i2c_sx1509_led_intensity.at(led)] = true;
+    }
+  }
+  for (I2CFrame *frame : {&red_frame_, &green_frame_, &yellow_frame_}) {
+    frame->managed[0x10] = true;
+    frame->managed[0x11] = true;
+  }
+  // 4 characters of 16 bits
+  for (uint8_t reg = 0; reg < 8; reg++) {
+    display_frame_.managed[reg] = true;
+  }
+  i2c_transactions_.store(0);
+  trace_hook_ = nullptr;
+  trace_context_ = nullptr;
+  trace_only_ = false;
+  for (auto &t : desired_track_) {
+    t.store((uint8_t)TrackLed::kOff);
+  }
+  applied_track_.fill(TrackLed::kUnknown);
+  desired_in_group_.store(0);
+  applied_in_group_ = 0;
+  in_group_applied_once_ = false;
+  desired_display_.store(0);
+  pending_.store(0);
+  worker_running_.store(false);
+  sem_init(&worker_wake_, 0, 0);
+}
+
+OutputI2C::~OutputI2C() {
+  StopWorker();
+  sem_destroy(&worker_wake_);
+}
+
+void OutputI2C::StartWorker() {
+  if (worker_running_.exchange(true)) { return; }
+  worker_ = std::thread(&OutputI2C::WorkerLoop, this);
+}
+
+void OutputI2C::StopWorker() {
+  if (!worker_running_.exchange(false)) { return; }
+  sem_post(&worker_wake_);
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+void OutputI2C::WorkerLoop() {
+  while (worker_running_.load(std::memory_order_acquire)) {
+    sem_wait(&worker_wake_);
+    // Take everything pending, later updates set their bits again
+    uint32_t pending = pending_.exchange(0, std::memory_order_acquire);
+    if (pending != 0) {
+      ApplyPending(pending);
+    }
+  }
+}
+
+void OutputI2C::ApplyPending(uint32_t pending) {
+  for (uint32_t track = 0; track < LED_TRACK_COUNT; track++) {
+    if (!(pending & (0x1 << track))) { continue; }
+    TrackLed state = (TrackLed)desired_track_[track].load(std::memory_order_relaxed);
+    if (state == applied_track_[track]) { continue; }
+    switch (state) {
+      case TrackLed::kRecording:
+        SignalRecord(track);
+        break;
+      case TrackLed::kPlayback:
+        SignalPlayback(track);
+        break;
+      case TrackLed::kMuted:
+        SignalMuted(track);
+        break;
+      default:
+        SignalOff(track);
+        break;
+    }
+    applied_track_[track] = state;
+  }
+
+  if (pending & kPendingInGroup) {
+    uint16_t in_group = desired_in_group_.load(std::memory_order_relaxed);
+    // Only the LEDs that changed, all of them the first time
+    uint16_t changed = in_group_applied_once_ ? in_group ^ applied_in_group_ : 0xFFFF;
+    for (uint32_t bit = 0; bit < LED_TRACK_COUNT; bit++) {
+      if (!(changed & (0x1 << bit))) { continue; }
+      if (in_group & (0x1 << bit)) {
+        SignalInGroup(bit);
+      } else {
+        SignalNotInGroup(bit);
+      }
+    }
+    applied_in_group_ = in_group;
+    in_group_applied_once_ = true;
+  }
+
+  if (pending & kPendingDisplay) {
+    uint16_t display = desired_display_.load(std::memory_order_relaxed);
+    uint8_t group_number = display & 0xFF;
+    switch ((GroupDisplay)(display >> 8)) {
+      case GroupDisplay::kActiveWithTrack:
+        SignalGroupActiveWithTrackThread(group_number);
+        break;
+      case GroupDisplay::kAddTrack:
+        SignalGroupAddTrackThread(group_number);
+        break;
+      case GroupDisplay::kActiveEmpty:
+        SignalGroupActiveEmptyThread(group_number);
+        break;
+      case GroupDisplay::kRemoveTrack:
+        SignalGroupRemoveTrackThread(group_number);
+        break;
+      case GroupDisplay::kInactive:
+        SignalGroupInactiveThread(group_number);
+        break;
+      default:
+        break;
+    }
+  }
+
+  FlushFrame(red_frame_);
+  FlushFrame(green_frame_);
+  FlushFrame(yellow_frame_);
+  FlushFrame(display_frame_);
+}
+
+void OutputI2C::SetRegisterTraceHook(I2CTraceHook hook, void *context) {
+  trace_context_ = context;
+  trace_hook_ = hook;
+}
+
+void OutputI2C::EnableTraceOnly() {
+  trace_only_ = true;
+}
+
+void OutputI2C::FlushPending() {
+  if (worker_running_.load()) { return; }
+  uint32_t pending = pending_.exchange(0, std::memory_order_acquire);
+  if (pending != 0) {
+    ApplyPending(pending);
+  }
+}
+
+// Wakes the worker only when the first bit goes pending, the worker takes all
+// bits at once. Safe to call from the audio thread
+void OutputI2C::MarkPending(uint32_t bits) {
+  uint32_t previous = pending_.fetch_or(bits, std::memory_order_release);
+  if (previous == 0 && worker_running_.load(std::memory_order_relaxed)) {
+    sem_post(&worker_wake_);
+  }
+}
+
+void OutputI2C::SetDesiredTrack(uint32_t track, TrackLed state) {
+  if (track >= LED_TRACK_COUNT) { return; }
+  desired_track_[track].store((uint8_t)state, std::memory_order_relaxed);
+  MarkPending(0x1 << track);
+}
+
+void OutputI2C::SetDesiredDisplay(GroupDisplay display, uint8_t group_number) {
+  desired_display_.store((uint16_t)display << 8 | group_number, std::memory_order_relaxed);
+  MarkPending(kPendingDisplay);
 }
 
 bool OutputI2C::InitializeWiringPiI2C() {
-  i2c_red_fd = wiringPiI2CSetup(EXP0_ADDR);
+  i2c_red_fd = HalI2CSetup(EXP0_ADDR);
   if (i2c_red_fd < 0){
     std::cout << "Error, device does not exist" << std::endl;
   }
 
-  i2c_green_fd = wiringPiI2CSetup(EXP1_ADDR);
+  i2c_green_fd = HalI2CSetup(EXP1_ADDR);
   if (i2c_green_fd < 0){
     std::cout << "Error, device does not exist" << std::endl;
   }
 
-  i2c_yellow_fd = wiringPiI2CSetup(EXP2_ADDR);
+  i2c_yellow_fd = HalI2CSetup(EXP2_ADDR);
   if (i2c_yellow_fd < 0){
     std::cout << "Error, device does not exist" << std::endl;
   }
 
-  i2c_disp0_fd = wiringPiI2CSetup(DISP0_ADDR);
+  i2c_disp0_fd = HalI2CSetup(DISP0_ADDR);
+  red_frame_.fd = i2c_red_fd;
+  green_frame_.fd = i2c_green_fd;
+  yellow_frame_.fd = i2c_yellow_fd;
+  display_frame_.fd = i2c_disp0_fd;
   if (i2c_disp0_fd < 0){
     std::cout << "Error, device does not exist" << std::endl;
   }
@@ -262,7 +444,7 @@ bool OutputI2C::InitializeWiringPiI2C() {
   bool at_least_one_dev = false;
   std::cout << "Initializing expander at " << std::hex << EXP0_ADDR << std::endl;
   if (i2c_red_fd >= 0) {
-    if (!InitializeExpander(i2c_red_fd)) {
+    if (!InitializeExpander(red_frame_)) {
       std::cout << "Error: failed to initialize device" << std::endl;
     } else {
       at_least_one_dev = true;
@@ -271,7 +453,7 @@ bool OutputI2C::InitializeWiringPiI2C() {
 
   std::cout << "Initializing expander at " << std::hex << EXP1_ADDR << std::endl;
   if (i2c_green_fd >= 0) {
-    if (!InitializeExpander(i2c_green_fd)) {
+    if (!InitializeExpander(green_frame_)) {
       std::cout << "Error: failed to initialize device" << std::endl;
     } else {
       at_least_one_dev = true;
@@ -280,7 +462,7 @@ bool OutputI2C::InitializeWiringPiI2C() {
 
   std::cout << "Initializing expander at " << std::hex << EXP2_ADDR << std::endl;
   if (i2c_yellow_fd >= 0) {
-    if (!InitializeExpander(i2c_yellow_fd)) {
+    if (!InitializeExpander(yellow_frame_)) {
       std::cout << "Error: failed to initialize device" << std::endl;
     } else {
       at_least_one_dev = true;
@@ -292,318 +474,273 @@ bool OutputI2C::InitializeWiringPiI2C() {
     displayOn(i2c_disp0_fd);
     displayClear(i2c_disp0_fd);
     uint16_t group_display [] = {'G', '-', '-', '-'};
-    display16(i2c_disp0_fd, group_display);
+    SetDisplayChars(group_display);
+    FlushFrame(display_frame_);
   }
 
+  if (at_least_one_dev || i2c_disp0_fd >= 0) {
+    StartWorker();
+    // Anything signalled before the bus was ready
+    if (pending_.load() != 0) {
+      sem_post(&worker_wake_);
+    }
+  }
   return at_least_one_dev;
 }
 
 // Call for each device, using it's own file descriptor
-bool OutputI2C::InitializeExpander(int fd) {
+bool OutputI2C::InitializeExpander(I2CFrame &frame) {
+  int fd = frame.fd;
   std::cout << "IE " << std::endl;
   for (uint32_t idx = 0; idx < i2c_sx1509_led_config.size(); idx++) { 
-    if (wiringPiI2CWriteReg16(fd,
+    if (HalI2CWriteReg16(fd,
                              i2c_sx1509_led_config.at(idx).addr,
                              i2c_sx1509_led_config.at(idx).value) < 0) {
       std::cout << "Error configuring I2C exp " << fd << ", init step " << std::hex << idx << std::endl;
       return false;
     }
   }
-  return ConfigureLEDDriver(fd);
+  return ConfigureLEDDriver(frame);
 }
 
 // Specific to SX1509
-bool OutputI2C::ConfigureLEDDriver(int fd) {
+bool OutputI2C::ConfigureLEDDriver(I2CFrame &frame) {
+  int fd = frame.fd;
   // Enable the oscillator
-  if (wiringPiI2CWriteReg8(fd, 0x1E, 0x58) < 0) {
+  if (HalI2CWriteReg8(fd, 0x1E, 0x58) < 0) {
     std::cout << "Error I2C enable clock divider" << std::endl;
     return false;
   }
   // Configure the LED driver clock
   // 101b 1000 0x58
-  uint8_t reg = wiringPiI2CReadReg8(fd, 0x1F);
+  uint8_t reg = HalI2CReadReg8(fd, 0x1F);
   reg &= ~(0b111 << 4);
   reg |= (0b101 << 4);
-  if (wiringPiI2CWriteReg8(fd, 0x1F, reg) < 0) {
+  if (HalI2CWriteReg8(fd, 0x1F, reg) < 0) {
     std::cout << "Error I2C config LED clock" << std::endl;
     return false;
   }
   // Enable LED driver
-  if (wiringPiI2CWriteReg16(fd, 0x20, 0xFFFF) < 0) {
+  if (HalI2CWriteReg16(fd, 0x20, 0xFFFF) < 0) {
     std::cout << "Error I2C enable LED driver" << std::endl;
     return false;
   }
-  // set all LEDs to off
+  // set all LEDs to off, then all data bits to zero - driver will start
+  // Device contents are unknown so the whole frame is written
   for (uint8_t led = 0; led < i2c_sx1509_led_ton.size(); led++) {
-    if (!SetLEDOff(fd, led)) {
-      return false;
-    }
-    if (!SetLEDIntensity(fd, led, false)) {
-      return false;
-    }
+    SetLEDOff(frame, led);
   }
-  // Set all data bits to zero - driver will start
-  wiringPiI2CWriteReg16(fd, 0x10, 0x0000);
-
+  frame.desired[0x10] = 0x00;
+  frame.desired[0x11] = 0x00;
+  frame.committed_valid = false;
+  FlushFrame(frame);
   return true;
 }
 
-// Only 16 LED per expander
-bool OutputI2C::SetLEDOff(int fd, uint16_t led) {
-  if (fd < 0) { return false; }
-  if (led > 15) { return false; }
-  uint8_t addr = i2c_sx1509_led_ton.at(led); 
-  if (wiringPiI2CWriteReg8(fd, addr, 0x0) < 0) {
-    std::cout << "Error I2C set LED On time to 0" << std::endl;
-    return false;
+// Only 16 LED per expander, these only change the desired frame, FlushFrame
+// writes it to the device
+// for LED 15:8 use addr 0x10, for LED 7:0 use addr 0x11, bit set turns the LED off
+// Blinking is done by the SX1509 LED driver, TOn/IOn/TOff are contiguous for
+// each LED and on and blink share the data bit, so mute and unmute of a
+// playing track is a single burst and nothing runs while the LED blinks
+static void SetLEDRegisters(I2CFrame &frame, uint16_t led, uint8_t ton, uint8_t toff,
+                            uint8_t intensity, bool data_off) {
+  frame.desired[i2c_sx1509_led_ton.at(led)] = ton;
+  frame.desired[i2c_sx1509_led_toff.at(led)] = toff;
+  frame.desired[i2c_sx1509_led_intensity.at(led)] = intensity;
+  uint8_t addr = (led > 7) ? 0x10 : 0x11;
+  uint8_t bit = 0x1 << ((led > 7) ? led - 8 : led);
+  if (data_off) {
+    frame.desired[addr] |= bit;
+  } else {
+    frame.desired[addr] &= ~bit;
   }
-  addr = i2c_sx1509_led_toff.at(led);
-  if (wiringPiI2CWriteReg8(fd, addr, 0x0) < 0) {
-    std::cout << "Error I2C set LED Off time to 0" << std::endl;
-    return false;
-  }
-  // for LED 15:8 use addr 0x10
-  // for LED 7:0 use addr 0x11
-  // Then reduce LED to 7:0 value as it's by bit in an 8bit register
-  addr = (led > 7) ? 0x10 : 0x11;
-  uint16_t led_temp = (led > 7) ? led - 8 : led;
-  uint8_t reg = wiringPiI2CReadReg8(fd, addr);
-  reg |= (0x1 << led_temp); // set to turn LED off
-  wiringPiI2CWriteReg8(fd, addr, reg);
-  return SetLEDIntensity(fd, led, false);
 }
 
-bool OutputI2C::SetLEDOn(int fd, uint16_t led) {
-  if (fd < 0) { return false; }
+bool OutputI2C::SetLEDOff(I2CFrame &frame, uint16_t led) {
+  if (frame.fd < 0 && !trace_only_) { return false; }
   if (led > 15) { return false; }
-  uint8_t addr = i2c_sx1509_led_ton.at(led); 
-  if (wiringPiI2CWriteReg8(fd, addr, 0x00) < 0) {
-    std::cout << "Error I2C set LED On time to 0x00" << std::endl;
-    return false;
-  }
-  addr = i2c_sx1509_led_toff.at(led);
-  if (wiringPiI2CWriteReg8(fd, addr, 0x00) < 0) {
-    std::cout << "Error I2C set LED Off time to 0" << std::endl;
-    return false;
-  }
-  // for LED 15:8 use addr 0x10
-  // for LED 7:0 use addr 0x11
-  // Then reduce LED to 7:0 value as it's by bit in an 8bit register
-  addr = (led > 7) ? 0x10 : 0x11;
-  uint16_t led_temp = (led > 7) ? led - 8 : led;
-  uint8_t reg = wiringPiI2CReadReg8(fd, addr);
-  reg &= ~(0x1 << led_temp); // clear to turn LED on
-  wiringPiI2CWriteReg8(fd, addr, reg);
-
-  return SetLEDIntensity(fd, led, true);
+  SetLEDRegisters(frame, led, 0x00, 0x00, 0x00, true);
+  return true;
 }
 
-bool OutputI2C::SetLEDIntensity(int fd, uint16_t led, bool set_max) {
-  if (fd < 0) { return false; }
+bool OutputI2C::SetLEDOn(I2CFrame &frame, uint16_t led) {
+  if (frame.fd < 0 && !trace_only_) { return false; }
   if (led > 15) { return false; }
-  uint8_t intensity = set_max ? 0x0C : 0x00;
-  uint8_t addr = i2c_sx1509_led_intensity.at(led); 
-  if (wiringPiI2CWriteReg8(fd, addr, intensity) < 0) {
-    std::cout << "Error I2C set LED intensity to " << intensity << std::endl;
-    return false;
-  }
+  SetLEDRegisters(frame, led, 0x00, 0x00, 0x0C, false);
   return true;
 }
 
-bool OutputI2C::SetLEDBlink(int fd, uint16_t led) {
-  if (fd < 0) { return false; }
+bool OutputI2C::SetLEDBlink(I2CFrame &frame, uint16_t led) {
+  if (frame.fd < 0 && !trace_only_) { return false; }
   if (led > 15) { return false; }
-  uint8_t addr = i2c_sx1509_led_ton.at(led);
-  if (wiringPiI2CWriteReg8(fd, addr, 0x01) < 0) {
-    std::cout << "Error I2C set LED On time to 0x1" << std::endl;
-    return false;
+  SetLEDRegisters(frame, led, 0x01, 0x0F, 0x0C, false);
+  return true;
+}
+
+// Writes each run of changed registers as one auto-increment burst. Runs are
+// joined across a short gap of unchanged registers we own, resending a byte is
+// cheaper than starting a new transaction
+void OutputI2C::FlushFrame(I2CFrame &frame) {
+  if (frame.fd < 0 && !trace_only_) { return; }
+  bool all_written = true;
+  uint32_t reg = 0;
+  while (reg < I2C_FRAME_SIZE) {
+    if (!frame.managed[reg] ||
+        (frame.committed_valid && frame.desired[reg] == frame.committed[reg])) {
+      reg++;
+      continue;
+    }
+    uint32_t start = reg;
+    uint32_t end = reg + 1;
+    uint32_t scan = end;
+    while (scan < I2C_FRAME_SIZE && frame.managed[scan] && scan - end <= I2C_BURST_MAX_GAP) {
+      if (!frame.committed_valid || frame.desired[scan] != frame.committed[scan]) {
+        end = scan + 1;
+      }
+      scan++;
+    }
+
+    if (frame.fd >= 0 && !HalI2CWriteBurst(frame.fd, start, &frame.desired[start], end - start)) {
+      RT_LOG("Error I2C burst write fd %d, reg 0x%x, %u bytes", frame.fd, start, end - start);
+      // Leave committed as is so the run is retried on the next flush
+      all_written = false;
+    } else {
+      if (trace_hook_ != nullptr) {
+        trace_hook_(trace_context_, frame.addr, start, &frame.desired[start], end - start);
+      }
+      for (uint32_t r = start; r < end; r++) {
+        frame.committed[r] = frame.desired[r];
+      }
+    }
+    i2c_transactions_.fetch_add(1, std::memory_order_relaxed);
+    reg = end;
   }
-  addr = i2c_sx1509_led_toff.at(led);
-  if (wiringPiI2CWriteReg8(fd, addr, 0x0F) < 0) {
-    std::cout << "Error I2C set LED Off time to 0x0F" << std::endl;
-    return false;
+  // Until a full write succeeds committed doesn't say what the device holds,
+  // registers that failed and happen to match it would never be written
+  if (all_written) {
+    frame.committed_valid = true;
   }
-  // for LED 15:8 use addr 0x10
-  // for LED 7:0 use addr 0x11
-  // Then reduce LED to 7:0 value as it's by bit in an 8bit register
-  addr = (led > 7) ? 0x10 : 0x11;
-  if (led > 7) { led -= 8; }
-  uint8_t reg = wiringPiI2CReadReg8(fd, addr);
-  reg &= ~(0x1 << led); // clear to turn LED on
-  wiringPiI2CWriteReg8(fd, addr, reg);
+}
 
-  return SetLEDIntensity(fd, led, true);
+uint32_t OutputI2C::GetI2CTransactionCount() {
+  return i2c_transactions_.load(std::memory_order_relaxed);
 }
 
 void OutputI2C::SignalRecord(uint32_t track) {
-  SetLEDOff(i2c_green_fd, track);
-  SetLEDOn(i2c_red_fd, track);
+  SetLEDOff(green_frame_, track);
+  SetLEDOn(red_frame_, track);
 }
 
 void OutputI2C::SignalPlayback(uint32_t track) {
-  SetLEDOff(i2c_red_fd, track);
-  SetLEDOn(i2c_green_fd, track);
+  SetLEDOff(red_frame_, track);
+  SetLEDOn(green_frame_, track);
 }
 
 void OutputI2C::SignalMuted(uint32_t track) {
-  SetLEDOff(i2c_red_fd, track);
-  SetLEDBlink(i2c_green_fd, track);
+  SetLEDOff(red_frame_, track);
+  SetLEDBlink(green_frame_, track);
 }
 
 void OutputI2C::SignalOff(uint32_t track) {
-  SetLEDOff(i2c_red_fd, track);
-  SetLEDOff(i2c_green_fd, track);
+  SetLEDOff(red_frame_, track);
+  SetLEDOff(green_frame_, track);
 }
 
 void OutputI2C::SignalInGroup(uint32_t track) {
-  SetLEDOn(i2c_yellow_fd, track);
+  SetLEDOn(yellow_frame_, track);
 }
 
 void OutputI2C::SignalNotInGroup(uint32_t track) {
-  SetLEDOff(i2c_yellow_fd, track);
+  SetLEDOff(yellow_frame_, track);
 }
 
-// Make these threads and run and die
+// Handed to the LED worker, see MarkPending
 void OutputI2C::SignalTrackRecording(uint32_t track) {
-  std::thread t(&OutputI2C::SignalRecord, this, track);
-  t.detach();
+  SetDesiredTrack(track, TrackLed::kRecording);
 }
 // solid green only - playback and repeat
 void OutputI2C::SignalTrackPlayback(uint32_t track) {
-  std::thread t(&OutputI2C::SignalPlayback, this, track);
-  t.detach();
+  SetDesiredTrack(track, TrackLed::kPlayback);
 }
 // blink green only - don't set when switching groups
 void OutputI2C::SignalTrackMuted(uint32_t track) {
-  std::thread t(&OutputI2C::SignalMuted, this, track);
-  t.detach();
+  SetDesiredTrack(track, TrackLed::kMuted);
 }
 // turn off LEDs - off state or not member of active group
 void OutputI2C::SignalTrackOff(uint32_t track) {
-  std::thread t(&OutputI2C::SignalOff, this, track);
-  t.detach();
-}
-// b - turn off all LEDs first then on bits set in tracks
-// tracks in playback - set LED
-// record will never be
-// tracks in mute
-// tracks off
-void OutputI2C::SignalTracksInGroupThread(
+  SetDesiredTrack(track, TrackLed::kOff);
+}
+// Members of the group show playback, mute or off, other tracks are off
+// Recording is never shown on a group change
+void OutputI2C::SignalTracksInGroup(
      uint16_t tracks_in_group,
      uint16_t tracks_in_playback,
      uint16_t tracks_in_mute,
      uint16_t tracks_off) {
-  std::cout << "I2C:SGIGT:" << std::hex << tracks_in_group << "," << tracks_in_playback << "," << tracks_in_mute << "," << tracks_off << std::endl;
-
-  // clear all track LED's other than group
-  for (uint32_t bit = 0; bit < 16; bit++) {
-    SignalOff(bit);
-  }
-
-  // Signal members of group
-  // Some strange bug/feature - all off first then on members
-  for (uint32_t bit = 0; bit < 16; bit++) {
-    SignalNotInGroup(bit);
-  }
+  RT_LOG("I2C:SGIGT:%x,%x,%x,%x", tracks_in_group, tracks_in_playback, tracks_in_mute, tracks_off);
 
-  for (uint32_t bit = 0; bit < 16; bit++) {
+  for (uint32_t bit = 0; bit < LED_TRACK_COUNT; bit++) {
+    TrackLed state = TrackLed::kOff;
     if (tracks_in_group & (0x1 << bit)) {
-      SignalInGroup(bit);
+      if (tracks_in_playback & (0x1 << bit)) {
+        state = TrackLed::kPlayback;
+      } else if (tracks_in_mute & (0x1 << bit)) {
+        state = TrackLed::kMuted;
+      }
     }
+    desired_track_[bit].store((uint8_t)state, std::memory_order_relaxed);
   }
-
-  // Signal tracks in playback if members of group
-  for (uint32_t bit = 0; bit < 16; bit++) {
-    if (tracks_in_playback & (0x1 << bit) &&
-	tracks_in_group & (0x1 << bit)) {
-      SignalPlayback(bit);
-    } 
-  }
-
-  // Signal tracks in mute if members of group
-  for (uint32_t bit = 0; bit < 16; bit++) {
-    if (tracks_in_mute & (0x1 << bit) &&
-	tracks_in_group & (0x1 << bit)) {
-      SignalMuted(bit);
-    } 
-  }
-
-  // Signal tracks off if members of group
-  for (uint32_t bit = 0; bit < 16; bit++) {
-    if (tracks_off & (0x1 << bit) &&
-	tracks_in_group & (0x1 << bit)) {
-      SignalOff(bit);
-    } 
-  }
-
-}
-
-// b - turn off all LEDs first then on bits set in tracks
-void OutputI2C::SignalTracksInGroup(
-     uint16_t tracks_in_group,
-     uint16_t tracks_in_playback,
-     uint16_t tracks_in_mute,
-     uint16_t tracks_off) {
-  std::thread t(&OutputI2C::SignalTracksInGroupThread, this,
-                tracks_in_group,
-		tracks_in_playback,
-		tracks_in_mute,
-		tracks_off);
-  t.detach();
+  desired_in_group_.store(tracks_in_group, std::memory_order_relaxed);
+  MarkPending(kPendingTracks | kPendingInGroup);
 }
 
 void OutputI2C::SignalGroupActiveWithTrackThread(uint8_t group_number) {
   uint16_t grp_num = 48 + group_number;
   uint16_t display_info[] = {'G', grp_num, '>', 'T'};
-  display16(i2c_disp0_fd, display_info);
+  SetDisplayChars(display_info);
 }
 
 void OutputI2C::SignalGroupAddTrackThread(uint8_t group_number) {
   uint16_t grp_num = 48 + group_number;
   uint16_t display_info[] = {'G', grp_num, 'T', '+'};
-  display16(i2c_disp0_fd, display_info);
+  SetDisplayChars(display_info);
 }
 
 void OutputI2C::SignalGroupActiveEmptyThread(uint8_t group_number) {
   uint16_t grp_num = 48 + group_number;
   uint16_t display_info[] = {'G', grp_num, '<', 'T'};
-  display16(i2c_disp0_fd, display_info);
+  SetDisplayChars(display_info);
 }
 
 void OutputI2C::SignalGroupRemoveTrackThread(uint8_t group_number) {
   uint16_t grp_num = 48 + group_number;
   uint16_t display_info[] = {'G', grp_num, 'T', '-'};
-  display16(i2c_disp0_fd, display_info);
+  SetDisplayChars(display_info);
 }
 
 void OutputI2C::SignalGroupInactiveThread(uint8_t group_number) {
   uint16_t grp_num = 48 + group_number;
   uint16_t display_info[] = {'G', grp_num, ' ', ' '};
-  display16(i2c_disp0_fd, display_info);
+  SetDisplayChars(display_info);
 }
 
 void OutputI2C::SignalGroupActiveWithTrack(uint8_t group_number) {
-  std::thread t(&OutputI2C::SignalGroupActiveWithTrackThread, this, group_number);
-  t.detach();
+  SetDesiredDisplay(GroupDisplay::kActiveWithTrack, group_number);
 }
 
 void OutputI2C::SignalGroupAddTrack(uint8_t group_number) {
-  std::thread t(&OutputI2C::SignalGroupAddTrackThread, this, group_number);
-  t.detach();
+  SetDesiredDisplay(GroupDisplay::kAddTrack, group_number);
 }
 
 void OutputI2C::SignalGroupActiveEmpty(uint8_t group_number) {
-  std::thread t(&OutputI2C::SignalGroupActiveEmptyThread, this, group_number);
-  t.detach();
+  SetDesiredDisplay(GroupDisplay::kActiveEmpty, group_number);
 }
 
 void OutputI2C::SignalGroupRemoveTrack(uint8_t group_number) {
-  std::thread t(&OutputI2C::SignalGroupRemoveTrackThread, this, group_number);
-  t.detach();
+  SetDesiredDisplay(GroupDisplay::kRemoveTrack, group_number);
 }
 
 void OutputI2C::SignalGroupInactive(uint8_t group_number) {
-  std::thread t(&OutputI2C::SignalGroupInactiveThread, this, group_number);
-  t.detach();
+  SetDesiredDisplay(GroupDisplay::kInactive, group_number);
 }
-
@@ -1,13 +1,57 @@
 #ifndef OUTPUT_I2C_H
 #define OUTPUT_I2C_H
 
+#include <array>
+#include <atomic>
+#include <thread>
 #include <vector>
+#include <semaphore.h>
 
 #define EXP0_ADDR 0x3E
 #define EXP1_ADDR 0x3F
 #define EXP2_ADDR 0x70
 #define DISP0_ADDR 0x72
 #define LEDS_PER_TRACK 3
+#define LED_TRACK_COUNT 16
+
+// Software copy of a device's registers. Changes are made to desired and
+// FlushFrame writes the registers that differ from committed, the last values
+// written. Only managed registers are ever written
+#define I2C_FRAME_SIZE 0x80
+// Unchanged registers resent to join two runs into one burst
+#define I2C_BURST_MAX_GAP 2
+
+struct I2CFrame {
+  int fd;
+  uint8_t addr;          // I2C address, reported to the register trace
+  std::array<uint8_t, I2C_FRAME_SIZE> desired;
+  std::array<uint8_t, I2C_FRAME_SIZE> committed;
+  std::array<bool, I2C_FRAME_SIZE> managed;
+  bool committed_valid;  // false until the device has been written in full
+};
+
+// Called for every burst write with the device address, first register and
+// the bytes written, after the write to the device
+typedef void (*I2CTraceHook)(void *context, uint8_t addr, uint8_t reg, const uint8_t *data, uint32_t length);
+
+// What a track's red/green LEDs should show
+enum class TrackLed : uint8_t {
+  kOff = 0,
+  kRecording,
+  kPlayback,
+  kMuted,
+  kUnknown    // Worker hasn't written the LEDs yet
+};
+
+// What the group display should show
+enum class GroupDisplay : uint8_t {
+  kNone = 0,
+  kActiveWithTrack,
+  kAddTrack,
+  kActiveEmpty,
+  kRemoveTrack,
+  kInactive
+};
 
 class OutputI2C {
   // Variables
@@ -17,16 +61,51 @@ class OutputI2C {
   int i2c_disp0_fd;
   int i2c_disp1_fd;
 
+  // Red, green and yellow SX1509 expanders and the HT16K33 display
+  I2CFrame red_frame_;
+  I2CFrame green_frame_;
+  I2CFrame yellow_frame_;
+  I2CFrame display_frame_;
+  std::atomic<uint32_t> i2c_transactions_;
+  I2CTraceHook trace_hook_;
+  void *trace_context_;
+  bool trace_only_;      // no devices, bursts only go to the trace hook
+
+  // LED worker - Signal* calls only record the state each LED should end up in
+  // and mark it pending, a single worker thread writes the latest state to the
+  // bus. Several updates to the same LED before the worker runs cost one write
+  std::array<std::atomic<uint8_t>, LED_TRACK_COUNT> desired_track_;
+  std::atomic<uint16_t> desired_in_group_;
+  std::atomic<uint16_t> desired_display_;   // GroupDisplay << 8 | group
+  // Bits 0-15 track LEDs, kPendingInGroup and kPendingDisplay
+  std::atomic<uint32_t> pending_;
+  // Worker thread only, what was last written to the bus
+  std::array<TrackLed, LED_TRACK_COUNT> applied_track_;
+  uint16_t applied_in_group_;
+  bool in_group_applied_once_;
+  std::atomic<bool> worker_running_;
+  sem_t worker_wake_;
+  std::thread worker_;
+
   // Methods
-  bool InitializeExpander(int fd);
-  bool ConfigureLEDDriver(int fd);
-  bool SetLEDOn(int fd, uint16_t led);
-  bool SetLEDOff(int fd, uint16_t led);
-  bool SetLEDBlink(int fd, uint16_t led);
-  bool SetLEDIntensity(int fd, uint16_t led, bool set_max);
+  bool InitializeExpander(I2CFrame &frame);
+  bool ConfigureLEDDriver(I2CFrame &frame);
+  bool SetLEDOn(I2CFrame &frame, uint16_t led);
+  bool SetLEDOff(I2CFrame &frame, uint16_t led);
+  bool SetLEDBlink(I2CFrame &frame, uint16_t led);
+  void SetDisplayChars(uint16_t *array);
+  void FlushFrame(I2CFrame &frame);
   int TrackToDevFd(uint32_t track);
 
-  // detached threads
+  void MarkPending(uint32_t bits);
+  void SetDesiredTrack(uint32_t track, TrackLed state);
+  void SetDesiredDisplay(GroupDisplay display, uint8_t group_number);
+  void StartWorker();
+  void StopWorker();
+  void WorkerLoop();
+  void ApplyPending(uint32_t pending);
+
+  // run on the LED worker
   void SignalRecord(uint32_t track);
   void SignalPlayback(uint32_t track);
   void SignalMuted(uint32_t track);
@@ -35,11 +114,6 @@ class OutputI2C {
   void SignalInGroup(uint32_t track);
   void SignalNotInGroup(uint32_t track);
 #endif
-  void SignalTracksInGroupThread(
-       uint16_t tracks_in_group,
-       uint16_t tracks_in_playback,
-       uint16_t tracks_in_mute,
-       uint16_t tracks_off);
   void SignalGroupActiveWithTrackThread(uint8_t group_number);
   void SignalGroupAddTrackThread(uint8_t group_number);
   void SignalGroupActiveEmptyThread(uint8_t group_number);
@@ -49,6 +123,7 @@ class OutputI2C {
   public:
 
   OutputI2C();
+  ~OutputI2C();
   bool InitializeWiringPiI2C();
   // solid red only - recording and overdub
   void SignalTrackRecording(uint32_t track);
@@ -69,6 +144,14 @@ class OutputI2C {
   void SignalGroupActiveEmpty(uint8_t group_number);
   void SignalGroupRemoveTrack(uint8_t group_number);
   void SignalGroupInactive(uint8_t group_number);
+  // Burst writes issued since startup
+  uint32_t GetI2CTransactionCount();
+  // Record every register write, set before InitializeWiringPiI2C
+  void SetRegisterTraceHook(I2CTraceHook hook, void *context);
+  // Run without the devices, writes are only reported to the trace hook
+  void EnableTraceOnly();
+  // Apply pending updates on the caller's thread, when no worker is running
+  void FlushPending();
 #ifdef DTEST_I2C
   void SignalInGroup(uint32_t track);
   void SignalNotInGroup(uint32_t track);
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "track_manager.h"
+#include "group_manager.h"
+#include "control_command.h"
+#include "mix_parameters.h"
+#include "wav_file.h"
+
+// Offline render - runs the track and group state machines and the mixdown
+// without JACK, as fast as the CPU allows, and writes the mix to a WAV file.
+// For regression checks and for profiling the engine on dev machines
+//
+// render [-i input.wav | -g generator] [-s script] [-n blocks] [-p period]
+//        [-r sample_rate] [-o output.wav]
+//
+// Generators: silence, sine:<hz>, noise, click:<blocks between clicks>
+// Script, one entry per line applied before the block, # starts a comment
+//   <block> track <n> down|doubledown|longpulse
+//   <block> group <n> down|doubledown|longpulse
+//   <block> gain <track> <gain>
+//   <block> master <gain>
+// Track events are for the last group pressed, as with the buttons. The mix is
+// mono, the way gpio_main runs the engine
+// Prints the render speed and a checksum of the mix
+
+#define RENDER_DEFAULT_BLOCKS 1000
+
+enum class ScriptAction : uint8_t {
+  kTrack = 0,
+  kGroup,
+  kGain,
+  kMaster
+};
+
+struct ScriptEntry {
+  uint64_t block;
+  ScriptAction action;
+  uint32_t number;
+  InputProcessedEvent event;
+  float value;
+};
+
+static TrackManager tm;
+static GroupManager gm;
+static MixParameters mix_parameters;
+
+static bool ParseEvent(const std::string &name, InputProcessedEvent &event) {
+  if (name == "down") {
+    event = InputProcessedEvent::kDown;
+  } else if (name == "doubledown") {
+    event = InputProcessedEvent::kDoubleDown;
+  } else if (name == "longpulse") {
+    event = InputProcessedEvent::kLongPulse;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool ReadScript(const char *path, std::vector<ScriptEntry> &script) {
+  std::ifstream file(path);
+  if (!file) {
+    std::cerr << "error: can't open " << path << std::endl;
+    return false;
+  }
+  std::string line;
+  uint32_t line_number = 0;
+  while (std::getline(file, line)) {
+    line_number++;
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    std::string action;
+    std::string argument;
+    ScriptEntry entry = {};
+    if (!(fields >> entry.block)) {
+      continue; // blank or comment
+    }
+    bool valid = (bool)(fields >> action);
+    if (valid && action == "master") {
+      entry.action = ScriptAction::kMaster;
+      valid = (bool)(fields >> entry.value);
+    } else if (valid) {
+      valid = (bool)(fields >> entry.number >> argument);
+      if (action == "track" || action == "group") {
+        entry.action = action == "track" ? ScriptAction::kTrack : ScriptAction::kGroup;
+        valid = valid && ParseEvent(argument, entry.event);
+        valid = valid && entry.number < (action == "track" ? MAX_TRACK_COUNT : MAX_GROUP_COUNT);
+      } else if (action == "gain") {
+        entry.action = ScriptAction::kGain;
+        entry.value = strtof(argument.c_str(), nullptr);
+      } else {
+        valid = false;
+      }
+    }
+    if (!valid) {
+      std::cerr << "error: " << path << ":" << line_number << ": can't parse '" << line << "'" << std::endl;
+      return false;
+    }
+    script.push_back(entry);
+  }
+  // Same block keeps the order of the file
+  std::stable_sort(script.begin(), script.end(),
+                   [](const ScriptEntry &a, const ScriptEntry &b) { return a.block < b.block; });
+  return true;
+}
+
+static bool Generate(const std::string &generator, uint32_t sample_rate, std::vector<float> &input) {
+  std::string name = generator.substr(0, generator.find(':'));
+  double parameter = 0.0;
+  if (generator.find(':') != std::string::npos) {
+    parameter = atof(generator.c_str() + generator.find(':') + 1);
+  }
+  uint32_t seed = 0x1234567;
+  for (uint32_t i = 0; i < input.size(); i++) {
+    if (name == "silence") {
+      input[i] = 0.0f;
+    } else if (name == "sine") {
+      input[i] = 0.5f * (float)sin(2.0 * M_PI * parameter * i / sample_rate);
+    } else if (name == "noise") {
+      seed = seed * 1664525 + 1013904223;
+      input[i] = 0.5f * (int32_t)seed / 2147483648.0f;
+    } else if (name == "click" && parameter >= 1.0) {
+      input[i] = i % (uint32_t)(parameter * SAMPLES_PER_BLOCK) == 0 ? 1.0f : 0.0f;
+    } else {
+      std::cerr << "error: unknown generator " << generator << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// FNV-1a of the output's bytes, identical renders have identical checksums
+static uint32_t Checksum(const std::vector<float> &samples) {
+  uint32_t hash = 2166136261u;
+  const uint8_t *bytes = (const uint8_t*)samples.data();
+  for (size_t i = 0; i < samples.size() * sizeof(float); i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// Same handling as AudioJack::Process
+static void ApplyScriptEntry(const ScriptEntry &entry, uint32_t &last_track, uint32_t &last_group) {
+  switch (entry.action) {
+    case ScriptAction::kTrack:
+    case ScriptAction::kGroup: {
+      ControlCommand command = {};
+      command.event = entry.event;
+      command.for_track = entry.action == ScriptAction::kTrack;
+      if (command.for_track) {
+        command.track = entry.number;
+      } else {
+        last_group = entry.number;
+      }
+      command.group = last_group;
+      DispatchControlCommand(command, tm, gm);
+      if (command.for_track) {
+        last_track = command.track;
+      }
+      break;
+    }
+    case ScriptAction::kGain:
+      mix_parameters.SetTrackGain(entry.number, entry.value);
+      break;
+    case ScriptAction::kMaster:
+      mix_parameters.SetMasterGain(entry.value);
+      break;
+  }
+}
+
+static void Usage() {
+  std::cerr << "usage: render [-i input.wav | -g generator] [-s script] [-n blocks] [-p period]" << std::endl
+            << "              [-r sample_rate] [-o output.wav]" << std::endl
+            << "generators: silence, sine:<hz>, noise, click:<blocks>" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  const char *input_path = nullptr;
+  const char *output_path = nullptr;
+  const char *script_path = nullptr;
+  std::string generator = "sine:440";
+  uint64_t blocks = 0;
+  uint32_t period = SAMPLES_PER_BLOCK;
+  uint32_t sample_rate = DEFAULT_SAMPLE_RATE;
+
+  for (int a = 1; a < argc; a++) {
+    std::string option = argv[a];
+    if (a + 1 >= argc) {
+      Usage();
+      return 1;
+    }
+    const char *value = argv[++a];
+    if (option == "-i") {
+      input_path = value;
+    } else if (option == "-g") {
+      generator = value;
+    } else if (option == "-s") {
+      script_path = value;
+    } else if (option == "-n") {
+      blocks = strtoull(value, nullptr, 10);
+    } else if (option == "-p") {
+      period = strtoul(value, nullptr, 10);
+    } else if (option == "-r") {
+      sample_rate = strtoul(value, nullptr, 10);
+    } else if (option == "-o") {
+      output_path = value;
+    } else {
+      Usage();
+      return 1;
+    }
+  }
+  if (period == 0) {
+    Usage();
+    return 1;
+  }
+
+  std::vector<ScriptEntry> script;
+  if (script_path != nullptr && !ReadScript(script_path, script)) {
+    return 1;
+  }
+
+  std::vector<float> input;
+  if (input_path != nullptr) {
+    if (!ReadWav(input_path, input, sample_rate)) {
+      return 1;
+    }
+    if (blocks == 0) {
+      blocks = (input.size() + SAMPLES_PER_BLOCK - 1) / SAMPLES_PER_BLOCK;
+    }
+  }
+  if (blocks == 0) {
+    blocks = script.empty() ? RENDER_DEFAULT_BLOCKS : script.back().block + RENDER_DEFAULT_BLOCKS;
+  }
+  uint64_t frames = blocks * SAMPLES_PER_BLOCK;
+  input.resize(frames, 0.0f);
+  if (input_path == nullptr && !Generate(generator, sample_rate, input)) {
+    return 1;
+  }
+  std::vector<float> output(frames, 0.0f);
+
+  tm.SetMixParameters(&mix_parameters);
+  std::cout << "Mixer kernel: " << MixerGetKernelName(MixerGetKernel()) << std::endl;
+
+  // Periods are split where a script entry is due, as commands split JACK's
+  uint32_t last_track = 0;
+  uint32_t last_group = MAX_GROUP_COUNT;
+  size_t next_entry = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t frame = 0; frame < frames;) {
+    while (next_entry < script.size() && script[next_entry].block * SAMPLES_PER_BLOCK <= frame) {
+      ApplyScriptEntry(script[next_entry++], last_track, last_group);
+    }
+    uint64_t chunk = std::min<uint64_t>(period - frame % period, frames - frame);
+    if (next_entry < script.size()) {
+      chunk = std::min<uint64_t>(chunk, script[next_entry].block * SAMPLES_PER_BLOCK - frame);
+    }
+    tm.ProcessFrames(last_track, &input[frame], &output[frame], chunk);
+    frame += chunk;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  double elapsed_s = std::chrono::duration<double>(elapsed).count();
+  double audio_s = (double)frames / sample_rate;
+  std::cout << "blocks: " << blocks << ", frames: " << frames << ", period: " << period << std::endl;
+  std::cout << "elapsed_ms: " << elapsed_s * 1000.0 << ", realtime_factor: "
+            << (elapsed_s > 0.0 ? audio_s / elapsed_s : 0.0) << std::endl;
+  std::cout << "checksum: " << std::hex << Checksum(output) << std::dec << std::endl;
+
+  if (output_path != nullptr && !WriteWav(output_path, {output}, sample_rate)) {
+    return 1;
+  }
+  return 0;
+}
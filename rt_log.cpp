@@ -0,0 +1,86 @@
+#include <chrono>
+#include <stdarg.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "rt_log.h"
+
+RtLog::RtLog() : dropped_(0), reported_dropped_(0), drain_running_(false) {
+  reading_.clear();
+}
+
+RtLog::~RtLog() {
+  StopDrainThread();
+}
+
+void RtLog::Write(const char *format, ...) {
+  RtLogRecord record;
+  va_list args;
+  va_start(args, format);
+  vsnprintf(record.text, RT_LOG_RECORD_SIZE, format, args);
+  va_end(args);
+  if (!ring_.Push(record)) {
+    // Full, never wait on the reader
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  if (!drain_running_.load(std::memory_order_relaxed)) {
+    Flush();
+  }
+}
+
+bool RtLog::Flush() {
+  if (reading_.test_and_set(std::memory_order_acquire)) {
+    return false;
+  }
+  RtLogRecord record;
+  while (ring_.Pop(record)) {
+    std::cout << record.text << std::endl;
+  }
+  uint32_t dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped != reported_dropped_) {
+    std::cout << "RtLog: dropped " << dropped - reported_dropped_ << " records" << std::endl;
+    reported_dropped_ = dropped;
+  }
+  reading_.clear(std::memory_order_release);
+  return true;
+}
+
+void RtLog::DrainLoop() {
+  // Below the audio thread and the control loop
+  setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 10);
+  while (drain_running_.load(std::memory_order_acquire)) {
+    Flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(RT_LOG_DRAIN_PERIOD_MS));
+  }
+  Flush();
+}
+
+void RtLog::StartDrainThread() {
+  if (drain_running_.exchange(true)) { return; }
+  drain_thread_ = std::thread(&RtLog::DrainLoop, this);
+}
+
+void RtLog::StopDrainThread() {
+  if (!drain_running_.exchange(false)) { return; }
+  if (drain_thread_.joinable()) {
+    drain_thread_.join();
+  }
+}
+
+uint32_t RtLog::GetDropped() {
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+#ifdef DTEST_RT_LOG
+void RtLog::SetQueueOnly(bool queue_only) {
+  drain_running_.store(queue_only);
+}
+#endif
+
+RtLog& RtLog::getInstance() {
+  static RtLog singleton;
+  return singleton;
+}
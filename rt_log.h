@@ -0,0 +1,67 @@
+#ifndef RT_LOG_H
+#define RT_LOG_H
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include "mpsc_ring.h"
+
+// Trace output that is safe to write from the audio thread. Each RT_LOG call
+// formats one line into a fixed size record of a bounded lock-free ring, any
+// thread may write. Records are printed by a low priority drain thread, or
+// straight away on the writer's thread if the drain thread hasn't been started
+// (tests rely on this to keep trace and test output in order).
+// Compiled out completely when NDEBUG is defined
+#define RT_LOG_RECORD_SIZE 120
+#define RT_LOG_RING_SIZE 256   // power of two
+#define RT_LOG_DRAIN_PERIOD_MS 10
+
+struct RtLogRecord {
+  char text[RT_LOG_RECORD_SIZE];
+};
+
+class RtLog {
+  MpscRing<RtLogRecord, RT_LOG_RING_SIZE> ring_;
+  // Only one thread prints at a time, it is the ring's consumer
+  std::atomic_flag reading_;
+  std::atomic<uint32_t> dropped_;
+  uint32_t reported_dropped_;
+  std::atomic<bool> drain_running_;
+  std::thread drain_thread_;
+
+#ifndef DTEST_RT_LOG
+  RtLog();
+  ~RtLog();
+#endif
+  RtLog(const RtLog& other);
+  RtLog& operator=(const RtLog& other);
+
+  void DrainLoop();
+
+  public:
+#ifdef DTEST_RT_LOG
+  // Tests use their own log rather than the singleton
+  RtLog();
+  ~RtLog();
+  // Writes only queue, as if the drain thread was running
+  void SetQueueOnly(bool queue_only);
+#endif
+  // printf style, one line per call, truncated to fit a record
+  void Write(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  // Prints every queued record, returns false if another thread is printing
+  bool Flush();
+  void StartDrainThread();
+  void StopDrainThread();
+  // Records lost because the ring was full, since startup
+  uint32_t GetDropped();
+
+  static RtLog& getInstance();
+};
+
+#ifdef NDEBUG
+#define RT_LOG(...) do {} while (0)
+#else
+#define RT_LOG(...) RtLog::getInstance().Write(__VA_ARGS__)
+#endif
+
+#endif // RT_LOG_H
@@ -0,0 +1,54 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <array>
+#include <atomic>
+
+// Wait-free single producer single consumer ring. One thread may Push and one
+// other thread may Pop, neither blocks, allocates or takes a lock.
+// Size must be a power of two, capacity is Size entries
+template <typename T, uint32_t Size>
+class SpscRing {
+  static_assert(Size != 0 && (Size & (Size - 1)) == 0, "Size must be a power of two");
+
+  std::array<T, Size> entries_;
+  // Free running counters, only the producer writes head_, only the consumer tail_
+  std::atomic<uint32_t> head_;
+  std::atomic<uint32_t> tail_;
+
+  public:
+  SpscRing() : head_(0), tail_(0) {}
+
+  // Producer side, false when full
+  bool Push(const T &entry) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == Size) {
+      return false;
+    }
+    entries_[head & (Size - 1)] = entry;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side, false when empty
+  bool Pop(T &entry) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) {
+      return false;
+    }
+    entry = entries_[tail & (Size - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Entries queued, exact from either side, a snapshot from any other thread
+  uint32_t GetCount() {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  bool IsEmpty() {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+};
+
+#endif // SPSC_RING_H
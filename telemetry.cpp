@@ -0,0 +1,114 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "telemetry.h"
+
+/*
+ * Writer
+ */
+
+TelemetryWriter::TelemetryWriter() : page_(nullptr) {}
+
+TelemetryWriter::~TelemetryWriter() {
+  Close();
+}
+
+bool TelemetryWriter::Open(const char *name) {
+  Close();
+  int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+  if (fd < 0) { return false; }
+  if (ftruncate(fd, sizeof(TelemetryPage)) != 0) {
+    close(fd);
+    return false;
+  }
+  void *mapping = mmap(nullptr, sizeof(TelemetryPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) { return false; }
+  page_ = (TelemetryPage*)mapping;
+  // Readers check the header, a count of 0 means nothing published yet
+  page_->sequence.store(0);
+  memset(&page_->data, 0, sizeof(page_->data));
+  page_->data_size = sizeof(TelemetryData);
+  page_->version = TELEMETRY_VERSION;
+  page_->magic = TELEMETRY_MAGIC;
+  return true;
+}
+
+// The object is left in place so a reader can see the last publish
+void TelemetryWriter::Close() {
+  if (page_ == nullptr) { return; }
+  munmap(page_, sizeof(TelemetryPage));
+  page_ = nullptr;
+}
+
+bool TelemetryWriter::IsOpen() {
+  return page_ != nullptr;
+}
+
+void TelemetryWriter::Publish(const TelemetryData &data) {
+  if (page_ == nullptr) { return; }
+  uint32_t sequence = page_->sequence.load(std::memory_order_relaxed);
+  page_->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(&page_->data, &data, sizeof(TelemetryData));
+  page_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/*
+ * Reader
+ */
+
+TelemetryReader::TelemetryReader() : page_(nullptr) {}
+
+TelemetryReader::~TelemetryReader() {
+  Close();
+}
+
+bool TelemetryReader::Open(const char *name) {
+  Close();
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) { return false; }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(TelemetryPage)) {
+    close(fd);
+    return false;
+  }
+  void *mapping = mmap(nullptr, sizeof(TelemetryPage), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) { return false; }
+  page_ = (TelemetryPage*)mapping;
+  if (page_->magic != TELEMETRY_MAGIC || page_->version != TELEMETRY_VERSION ||
+      page_->data_size != sizeof(TelemetryData)) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void TelemetryReader::Close() {
+  if (page_ == nullptr) { return; }
+  munmap(page_, sizeof(TelemetryPage));
+  page_ = nullptr;
+}
+
+bool TelemetryReader::Read(TelemetryData &data) {
+  if (page_ == nullptr) { return false; }
+  for (uint32_t attempt = 0; attempt < TELEMETRY_READ_RETRIES; attempt++) {
+    uint32_t before = page_->sequence.load(std::memory_order_acquire);
+    if (before == 0) { return false; }
+    if (before & 1) { continue; }
+    memcpy(&data, &page_->data, sizeof(TelemetryData));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (page_->sequence.load(std::memory_order_relaxed) == before) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t TelemetryReader::GetSequence() {
+  if (page_ == nullptr) { return 0; }
+  return page_->sequence.load(std::memory_order_acquire) / 2;
+}
@@ -0,0 +1,93 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <stdint.h>
+#include "util.h"
+
+// Live engine metrics in POSIX shared memory, for a display or a reader on
+// another process while the looper runs without a console. The audio thread
+// publishes about TELEMETRY_RATE_HZ times a second under a sequence count,
+// odd while it is writing. The writer never waits, a reader copies the data
+// and retries if the count moved or was odd
+#define TELEMETRY_SHM_NAME "/rpi_looper_telemetry"
+#define TELEMETRY_MAGIC 0x504F4F4C   // "LOOP"
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_RATE_HZ 30
+// Reader gives up after this many torn copies in a row
+#define TELEMETRY_READ_RETRIES 100
+
+// Fixed size fields only, the layout is shared with the reader
+struct TelemetryData {
+  uint64_t timestamp_ns;       // CLOCK_MONOTONIC of the cycle that published
+  uint64_t frame;              // Frames processed since startup
+  uint32_t sample_rate;
+  uint32_t master_current_index;
+  uint32_t master_end_index;
+  uint8_t track_state[MAX_TRACK_COUNT];  // TrackState values
+  uint8_t active_group;
+  uint8_t last_track;
+  uint16_t reserved;
+  // Busy time over period time since the last publish, and the worst cycle since startup
+  uint32_t dsp_load_permille;
+  uint32_t worst_load_permille;
+  uint32_t xruns;
+  uint32_t late_cycles;
+  // Control commands and overrun records waiting to be taken
+  uint32_t command_queue_depth;
+  uint32_t overrun_queue_depth;
+  uint32_t pool_pages_in_use;
+  uint32_t pool_page_count;
+  // Absolute peak since the last publish, left and right
+  float input_peak[2];
+  float output_peak[2];
+};
+
+// The shared memory object
+struct TelemetryPage {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t data_size;
+  std::atomic<uint32_t> sequence;
+  TelemetryData data;
+};
+
+class TelemetryWriter {
+  TelemetryPage *page_;
+
+  TelemetryWriter(const TelemetryWriter& other);
+  TelemetryWriter& operator=(const TelemetryWriter& other);
+
+  public:
+  TelemetryWriter();
+  ~TelemetryWriter();
+
+  // Creates or reuses the shared memory object, call before processing starts
+  bool Open(const char *name = TELEMETRY_SHM_NAME);
+  void Close();
+  bool IsOpen();
+  // Audio thread, a fixed size copy between two sequence stores
+  void Publish(const TelemetryData &data);
+};
+
+class TelemetryReader {
+  TelemetryPage *page_;
+
+  TelemetryReader(const TelemetryReader& other);
+  TelemetryReader& operator=(const TelemetryReader& other);
+
+  public:
+  TelemetryReader();
+  ~TelemetryReader();
+
+  // False if the object doesn't exist or was made by another version
+  bool Open(const char *name = TELEMETRY_SHM_NAME);
+  void Close();
+  // Consistent copy of the last publish, false if nothing has been published
+  // yet or the writer kept it busy for every retry
+  bool Read(TelemetryData &data);
+  // Publishes so far, changes every time the data does
+  uint32_t GetSequence();
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,113 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <math.h>
+#include <stdlib.h>
+#include "telemetry.h"
+#include "track.h"
+
+// Reader for the telemetry gpio_main publishes in shared memory, runs next to
+// the looper and prints one line per update
+//
+// telemetry [-n count] [-i interval_ms] [-s shm_name]
+//
+// Tracks are shown one character each, track 0 first:
+//   . off  r record  o overdub  p playback  P repeat  m muted
+// Peaks are in dBFS, left/right
+
+#define TELEMETRY_DEFAULT_INTERVAL_MS 100
+
+static char TrackStateChar(uint8_t state) {
+  switch ((TrackState)state) {
+    case TrackState::kOff:
+      return '.';
+    case TrackState::kOverdub:
+      return 'o';
+    case TrackState::kPlayback:
+      return 'p';
+    case TrackState::kRepeat:
+      return 'P';
+    case TrackState::kRecord:
+      return 'r';
+    case TrackState::kMuted:
+      return 'm';
+    default:
+      return '?';
+  }
+}
+
+static float PeakDb(float peak) {
+  return peak > 0.0f ? 20.0f * log10f(peak) : -99.9f;
+}
+
+static void PrintTelemetry(const TelemetryData &data) {
+  std::string tracks;
+  for (uint32_t t = 0; t < MAX_TRACK_COUNT; t++) {
+    tracks += TrackStateChar(data.track_state[t]);
+  }
+  std::cout << std::fixed << std::setprecision(1)
+            << tracks
+            << " group " << (int)data.active_group
+            << " track " << (int)data.last_track
+            << " master " << data.master_current_index << "/" << data.master_end_index
+            << " load " << data.dsp_load_permille / 10.0f << "%"
+            << " worst " << data.worst_load_permille / 10.0f << "%"
+            << " xruns " << data.xruns
+            << " late " << data.late_cycles
+            << " queues " << data.command_queue_depth << "/" << data.overrun_queue_depth
+            << " pages " << data.pool_pages_in_use << "/" << data.pool_page_count
+            << " in " << PeakDb(data.input_peak[0]) << "/" << PeakDb(data.input_peak[1])
+            << " out " << PeakDb(data.output_peak[0]) << "/" << PeakDb(data.output_peak[1])
+            << std::endl;
+}
+
+static void Usage() {
+  std::cerr << "usage: telemetry [-n count] [-i interval_ms] [-s shm_name]" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  const char *name = TELEMETRY_SHM_NAME;
+  uint64_t count = 0;
+  uint32_t interval_ms = TELEMETRY_DEFAULT_INTERVAL_MS;
+
+  for (int a = 1; a < argc; a++) {
+    std::string option = argv[a];
+    if (a + 1 >= argc) {
+      Usage();
+      return 1;
+    }
+    const char *value = argv[++a];
+    if (option == "-n") {
+      count = strtoull(value, nullptr, 10);
+    } else if (option == "-i") {
+      interval_ms = strtoul(value, nullptr, 10);
+    } else if (option == "-s") {
+      name = value;
+    } else {
+      Usage();
+      return 1;
+    }
+  }
+
+  TelemetryReader reader;
+  if (!reader.Open(name)) {
+    std::cerr << "error: no telemetry at " << name << ", is the looper running?" << std::endl;
+    return 1;
+  }
+  // Only new publishes are printed, a stopped looper prints nothing
+  uint32_t last_sequence = 0;
+  uint64_t printed = 0;
+  while (count == 0 || printed < count) {
+    uint32_t sequence = reader.GetSequence();
+    TelemetryData data;
+    if (sequence != last_sequence && reader.Read(data)) {
+      last_sequence = sequence;
+      PrintTelemetry(data);
+      printed++;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+  }
+  return 0;
+}
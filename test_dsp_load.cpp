@@ -0,0 +1,110 @@
+#include <iostream>
+#include <thread>
+#include "dsp_load.h"
+
+#define TEST_PERIOD_NS 1000000
+
+// Three cycles at half load and one late, 500us lands in the <512us bucket
+// and 1500us in the <2048us bucket
+bool Test_CycleAccounting(void) {
+  DspLoadMonitor monitor;
+  OverrunCause cause;
+  bool result = true;
+  for (int i = 0; i < 3; i++) {
+    if (monitor.AddCycle(500000, TEST_PERIOD_NS, cause)) {
+      std::cout << "error: cycle within its period recorded" << std::endl;
+      result = false;
+    }
+  }
+  if (!monitor.AddCycle(1500000, TEST_PERIOD_NS, cause) || cause != OverrunCause::kLate) {
+    std::cout << "error: late cycle not recorded" << std::endl;
+    result = false;
+  }
+  if (monitor.GetCycleCount() != 4 || monitor.GetBucket(8) != 3 || monitor.GetBucket(10) != 1) {
+    std::cout << "error: " << monitor.GetCycleCount() << " cycles, buckets "
+              << monitor.GetBucket(8) << " " << monitor.GetBucket(10) << std::endl;
+    result = false;
+  }
+  if (monitor.GetWorstCycleNs() != 1500000 || monitor.GetWorstLoadPermille() != 1500 ||
+      monitor.GetMeanLoadPermille() != 750 || monitor.GetLateCycles() != 1) {
+    std::cout << "error: worst " << monitor.GetWorstCycleNs() << "ns " << monitor.GetWorstLoadPermille()
+              << ", mean " << monitor.GetMeanLoadPermille() << ", late " << monitor.GetLateCycles() << std::endl;
+    result = false;
+  }
+  monitor.Print("dsp_load");
+  return result;
+}
+
+// An xrun reported from another thread is recorded once, on the next cycle,
+// even though that cycle was on time
+bool Test_XrunRecorded(void) {
+  DspLoadMonitor monitor;
+  OverrunCause cause;
+  bool result = true;
+  std::thread xrun_thread([&monitor]() { monitor.AddXrun(); });
+  xrun_thread.join();
+  if (!monitor.AddCycle(100000, TEST_PERIOD_NS, cause) || cause != OverrunCause::kXrun) {
+    std::cout << "error: xrun not recorded" << std::endl;
+    result = false;
+  }
+  if (monitor.AddCycle(100000, TEST_PERIOD_NS, cause)) {
+    std::cout << "error: xrun recorded twice" << std::endl;
+    result = false;
+  }
+  // A late cycle with an xrun pending is recorded as the xrun but still counted late
+  monitor.AddXrun();
+  if (!monitor.AddCycle(1500000, TEST_PERIOD_NS, cause) || cause != OverrunCause::kXrun) {
+    std::cout << "error: second xrun not recorded" << std::endl;
+    result = false;
+  }
+  if (monitor.GetXruns() != 2 || monitor.GetLateCycles() != 1) {
+    std::cout << "error: " << monitor.GetXruns() << " xruns, " << monitor.GetLateCycles() << " late" << std::endl;
+    result = false;
+  }
+  return result;
+}
+
+// Records come out in order, those that don't fit are counted and dropped
+bool Test_OverrunQueue(void) {
+  DspLoadMonitor monitor;
+  OverrunRecord record = {};
+  bool result = true;
+  for (uint32_t i = 0; i < DSP_OVERRUN_QUEUE_SIZE + 3; i++) {
+    record.master_index = i;
+    record.tracks_playing = 0x1 << (i % 16);
+    monitor.AddOverrun(record);
+  }
+  if (monitor.GetDroppedRecords() != 3) {
+    std::cout << "error: " << monitor.GetDroppedRecords() << " dropped" << std::endl;
+    result = false;
+  }
+  uint32_t count = 0;
+  while (monitor.PopOverrun(record)) {
+    if (record.master_index != count || record.tracks_playing != 0x1 << (count % 16)) {
+      std::cout << "error: record " << count << " out of order" << std::endl;
+      PrintOverrunRecord(record);
+      result = false;
+    }
+    count++;
+  }
+  if (count != DSP_OVERRUN_QUEUE_SIZE) {
+    std::cout << "error: " << count << " records" << std::endl;
+    result = false;
+  }
+  return result;
+}
+
+int main() {
+  std::cout << "** test_dsp_load.cpp **" << std::endl;
+  bool tests[3] = {false};
+  tests[0] = Test_CycleAccounting();
+  tests[1] = Test_XrunRecorded();
+  tests[2] = Test_OverrunQueue();
+  for (auto result : tests) {
+    if (!result) {
+      std::cout << "---> TEST FAILED" << std::endl;
+    }
+    std::cout << result << std::endl;
+  }
+  return 0;
+}
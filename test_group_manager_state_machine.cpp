@@ -4,6 +4,8 @@
 #include <sys/time.h>    
 #include "group_manager.h"
 #include "group_manager_states.h"
+#include "control_command.h"
+#include "spsc_ring.h"
 
 static TrackManager tm;
 
@@ -531,6 +533,131 @@ void Test_GroupSwapTests(GroupManager &gm, TrackManager &tm) {
 }
 #endif
 
+// Commands queued by the control thread and applied later, in order, by the audio thread
+bool Test_ControlCommandQueue() {
+  std::cout << std::endl << "** test_group_manager_state_machine.cpp: Control command queue **" << std::endl;
+  static TrackManager cmd_tm;
+  GroupManager cmd_gm;
+  SpscRing<ControlCommand, CONTROL_QUEUE_SIZE> ring;
+  ControlCommand command;
+
+  std::cout << "    fill the queue" << std::endl;
+  for (uint32_t i = 0; i < CONTROL_QUEUE_SIZE; i++) {
+    command = {InputProcessedEvent::kDown, i % MAX_TRACK_COUNT, 0, true};
+    if (!ring.Push(command)) {
+      std::cout << "error: push " << i << " failed before queue full" << std::endl;
+      return false;
+    }
+  }
+  if (ring.Push(command)) {
+    std::cout << "error: push succeeded on a full queue" << std::endl;
+    return false;
+  }
+  for (uint32_t i = 0; i < CONTROL_QUEUE_SIZE; i++) {
+    if (!ring.Pop(command) || command.track != i % MAX_TRACK_COUNT) {
+      std::cout << "error: pop " << i << " out of order" << std::endl;
+      return false;
+    }
+  }
+  if (ring.Pop(command)) {
+    std::cout << "error: pop succeeded on an empty queue" << std::endl;
+    return false;
+  }
+
+  std::cout << "    add track 3 to group 0 then record tracks 3 and 5" << std::endl;
+  ControlCommand commands[] = {
+    {InputProcessedEvent::kDown, MAX_TRACK_COUNT, 0, false},  // group 0 active
+    {InputProcessedEvent::kDown, MAX_TRACK_COUNT, 0, false},  // add tracks
+    {InputProcessedEvent::kDown, 3, 0, true},
+    {InputProcessedEvent::kDown, 3, 1, false},                // group 1 active
+    {InputProcessedEvent::kDown, 3, 0, false},                // group 0 active
+    {InputProcessedEvent::kDown, 3, 0, true},                 // record track 3
+    {InputProcessedEvent::kDown, 5, 0, true}                  // not in group 0
+  };
+  for (auto &c : commands) {
+    ring.Push(c);
+  }
+  // Nothing changes until the audio thread drains the queue
+  if (!cmd_tm.tracks.at(3).IsTrackOff() || cmd_gm.GetActiveGroup() != MAX_GROUP_COUNT) {
+    std::cout << "error: state changed before commands were applied" << std::endl;
+    return false;
+  }
+  while (ring.Pop(command)) {
+    DispatchControlCommand(command, cmd_tm, cmd_gm);
+  }
+  bool result = cmd_gm.IsStateActive() && cmd_gm.GetActiveGroup() == 0;
+  if (!result) {
+    std::cout << "error: group 0 not active" << std::endl;
+    return result;
+  }
+  result = cmd_tm.tracks.at(3).IsTrackInRecord();
+  if (!result) {
+    std::cout << "error: track 3 not recording" << std::endl;
+    return result;
+  }
+  result = !cmd_tm.tracks.at(5).IsTrackInRecord();
+  if (!result) {
+    std::cout << "error: track 5 outside group 0 changed state" << std::endl;
+  }
+  return result;
+}
+
+// Runs 1ms periods of 48 frames through the scheduler the way AudioJack::Process
+// does, returns the frame the command was applied at
+static uint64_t RunScheduledCommand(uint32_t push_after_periods, uint32_t &late) {
+  const uint64_t t0 = 1000000000ULL;
+  const uint64_t period_ns = 1000000ULL;
+  const uint32_t period_frames = 48;
+  CommandScheduler scheduler;
+  scheduler.SetSampleRate(48000);
+  ControlCommand command = {InputProcessedEvent::kDown, 3, 0, true};
+  // Pressed 1ms into the first period, 48 + 256 frames ahead is frame 304
+  command.timestamp_ns = t0 + 1000000ULL;
+  uint64_t applied_frame = UINT64_MAX;
+  for (uint32_t period = 0; period < 20; period++) {
+    scheduler.StartPeriod(t0 + period * period_ns);
+    if (period == push_after_periods) {
+      scheduler.Push(command);
+    }
+    uint32_t done = 0;
+    while (done < period_frames) {
+      ControlCommand due;
+      while (scheduler.PopDue(due)) {
+        applied_frame = scheduler.GetCurrentFrame();
+      }
+      uint32_t chunk = scheduler.FramesToNextCommand(period_frames - done);
+      scheduler.Advance(chunk);
+      done += chunk;
+    }
+  }
+  late = scheduler.GetLateCommands();
+  return applied_frame;
+}
+
+// The frame a command takes effect at only depends on when the button was
+// pressed, not on when the control thread queued it
+bool Test_ScheduledCommands() {
+  std::cout << std::endl << "** test_group_manager_state_machine.cpp: Scheduled commands **" << std::endl;
+  uint32_t late = 0;
+  bool result = true;
+  for (uint32_t push_after = 1; push_after <= 5; push_after++) {
+    uint64_t frame = RunScheduledCommand(push_after, late);
+    std::cout << "    queued in period " << push_after << ", applied at frame " << frame << std::endl;
+    if (frame != 304 || late != 0) {
+      std::cout << "error: expected frame 304" << std::endl;
+      result = false;
+    }
+  }
+  // Queued in period 9 after its frame has passed, applied straight away and counted late
+  uint64_t frame = RunScheduledCommand(9, late);
+  std::cout << "    queued in period 9, applied at frame " << frame << std::endl;
+  if (frame != 432 || late != 1) {
+    std::cout << "error: late command not applied at once" << std::endl;
+    result = false;
+  }
+  return result;
+}
+
 int main() {
   std::cout << "** test_group_manager.cpp **" << std::endl;
   GroupManager gm;
@@ -547,6 +674,14 @@ int main() {
   if (!test) {
     std::cout << "--> TEST FAILED" << std::endl;
   }
+  test = Test_ControlCommandQueue();
+  if (!test) {
+    std::cout << "--> TEST FAILED" << std::endl;
+  }
+  test = Test_ScheduledCommands();
+  if (!test) {
+    std::cout << "--> TEST FAILED" << std::endl;
+  }
 
 #if 0
   Test_RemoveTracksFromGroups(gm, tm);
@@ -25,7 +25,7 @@ main (int argc, char *argv[])
 {
 
   jack.SetTrackManagerPtr(&tm, nullptr);
-  jack.SetInputGpioPtr(&gi);
+  jack.SetGroupManagerPtr(&gm);
   jack.Init(argc, argv);
 
 //int main() {
@@ -69,8 +69,8 @@ main (int argc, char *argv[])
 
   // Hammer on this but need to handle multiple events case!
   while(1) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    if (gi.ProcessAndHandleInputEvents()) {
+    gi.WaitForEvents(-1);
+    while (gi.ProcessAndHandleInputEvents()) {
       if (gi.LastEventWasForTrack()) {
 	      std::cout << "Track:" << gi.GetLastTrack() << std::endl;
       } else {
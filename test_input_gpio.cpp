@@ -0,0 +1,225 @@
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <time.h>
+#include "util.h"
+#include "input_gpio.h"
+#include "hal_sim.h"
+#include "mpsc_ring.h"
+
+static InputGpio gi;
+
+static const uint64_t kMs = 1000000ULL;
+
+static uint64_t NowNs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static bool LastEventIs(InputProcessedEvent event) {
+  switch (event) {
+    case InputProcessedEvent::kDown:
+      return gi.LastEventWasDown();
+    case InputProcessedEvent::kUp:
+      return gi.LastEventWasUp();
+    case InputProcessedEvent::kDoubleDown:
+      return gi.LastEventWasDoubleDown();
+    case InputProcessedEvent::kShortPulse:
+      return gi.LastEventWasShortPulse();
+    case InputProcessedEvent::kLongPulse:
+      return gi.LastEventWasLongPulse();
+    default:
+      return false;
+  }
+}
+
+static bool ExpectEvent(InputProcessedEvent event, const char *name, int track) {
+  if (!gi.ProcessAndHandleInputEvents()) {
+    std::cout << "error: no event, expected " << name << std::endl;
+    return false;
+  }
+  if (!LastEventIs(event)) {
+    std::cout << "error: expected " << name << std::endl;
+    return false;
+  }
+  if (!gi.LastEventWasForTrack() || gi.GetLastTrack() != track) {
+    std::cout << "error: " << name << " for track " << gi.GetLastTrack() << ", expected " << track << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Track 8 is wiringPi pin 0, track 9 is pin 2
+bool Test_DoubleDownIsPerPin(void) {
+  bool result = true;
+  uint64_t t = NowNs() - 5000 * kMs;
+  gi.Reset();
+  // Down on two different buttons close together are both plain downs
+  gi.InjectEvent(InputProcessedEvent::kDown, 0, t);
+  gi.InjectEvent(InputProcessedEvent::kUp, 0, t + 50 * kMs);
+  gi.InjectEvent(InputProcessedEvent::kDown, 2, t + 100 * kMs);
+  gi.InjectEvent(InputProcessedEvent::kUp, 2, t + 150 * kMs);
+  // Second press of track 8 refines the first
+  gi.InjectEvent(InputProcessedEvent::kDown, 0, t + 200 * kMs);
+  gi.InjectEvent(InputProcessedEvent::kUp, 0, t + 250 * kMs);
+
+  result &= ExpectEvent(InputProcessedEvent::kDown, "Down", 8);
+  result &= ExpectEvent(InputProcessedEvent::kShortPulse, "ShortPulse", 8);
+  result &= ExpectEvent(InputProcessedEvent::kDown, "Down", 9);
+  result &= ExpectEvent(InputProcessedEvent::kShortPulse, "ShortPulse", 9);
+  result &= ExpectEvent(InputProcessedEvent::kDoubleDown, "DoubleDown", 8);
+  result &= ExpectEvent(InputProcessedEvent::kShortPulse, "ShortPulse", 8);
+  if (gi.ProcessAndHandleInputEvents()) {
+    std::cout << "error: unexpected extra event" << std::endl;
+    result = false;
+  }
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+  return result;
+}
+
+// Holding a button reports the long pulse without waiting for the up
+bool Test_LongPressWhileHeld(void) {
+  bool result = true;
+  gi.Reset();
+  gi.InjectEvent(InputProcessedEvent::kDown, 0, NowNs() - 2000 * kMs);
+
+  result &= ExpectEvent(InputProcessedEvent::kDown, "Down", 8);
+  result &= ExpectEvent(InputProcessedEvent::kLongPulse, "LongPulse", 8);
+  if (gi.ProcessAndHandleInputEvents()) {
+    std::cout << "error: long pulse sent twice" << std::endl;
+    result = false;
+  }
+  // The up after the long pulse isn't a second gesture
+  gi.InjectEvent(InputProcessedEvent::kUp, 0, NowNs());
+  result &= ExpectEvent(InputProcessedEvent::kUp, "Up", 8);
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+  return result;
+}
+
+// Edges on the simulated pins go through the ISR, the debounce and the
+// gestures with the times they were injected at
+bool Test_SimulatedPinEdges(void) {
+  bool result = HalSelectBackend(HalBackendType::kSim) && gi.InitializeWiringPiGpio();
+  uint64_t t = NowNs() - 5000 * kMs;
+  gi.Reset();
+  // Track 10 is wiringPi pin 3, the bounce within DEBOUNCE_TIME_US is dropped
+  SimGpioSetLevel(3, HAL_LOW, t);
+  SimGpioSetLevel(3, HAL_HIGH, t + 1 * kMs);
+  SimGpioSetLevel(3, HAL_LOW, t + 2 * kMs);
+  SimGpioSetLevel(3, HAL_HIGH, t + 100 * kMs);
+
+  result &= ExpectEvent(InputProcessedEvent::kDown, "Down", 10);
+  if (gi.GetLastEventTime() != t) {
+    std::cout << "error: down at " << gi.GetLastEventTime() << ", expected " << t << std::endl;
+    result = false;
+  }
+  result &= ExpectEvent(InputProcessedEvent::kShortPulse, "ShortPulse", 10);
+  if (gi.ProcessAndHandleInputEvents()) {
+    std::cout << "error: bounce was not filtered" << std::endl;
+    result = false;
+  }
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+  return result;
+}
+
+#define TEST_PRODUCERS 4
+
+struct TestEntry {
+  uint32_t producer;
+  uint32_t sequence;
+};
+
+// Producers start together and push count entries each while the consumer
+// drains. Each producer's entries must come out in the order it pushed them,
+// every entry is either popped or counted as dropped by its producer
+static bool RunConcurrentProducers(uint32_t count, uint32_t &dropped) {
+  MpscRing<TestEntry, MAX_EVENT_QUEUE_SIZE> ring;
+  std::atomic<bool> start(false);
+  std::atomic<uint32_t> drops(0);
+  std::atomic<uint32_t> producers_done(0);
+  std::vector<std::thread> producers;
+  for (uint32_t p = 0; p < TEST_PRODUCERS; p++) {
+    producers.emplace_back([&, p]() {
+      while (!start.load()) {}
+      for (uint32_t i = 0; i < count; i++) {
+        if (!ring.Push({p, i})) {
+          drops.fetch_add(1);
+        }
+      }
+      producers_done.fetch_add(1);
+    });
+  }
+  std::vector<int64_t> last(TEST_PRODUCERS, -1);
+  uint32_t popped = 0;
+  bool result = true;
+  start.store(true);
+  while (true) {
+    bool done = producers_done.load() == TEST_PRODUCERS;
+    TestEntry entry;
+    while (ring.Pop(entry)) {
+      if (entry.producer >= TEST_PRODUCERS || (int64_t)entry.sequence <= last[entry.producer]) {
+        std::cout << "error: producer " << entry.producer << " entry " << entry.sequence
+                  << " out of order" << std::endl;
+        result = false;
+      } else {
+        last[entry.producer] = entry.sequence;
+      }
+      popped++;
+    }
+    if (done) { break; }
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  dropped = drops.load();
+  if (popped + dropped != TEST_PRODUCERS * count) {
+    std::cout << "error: " << popped << " popped and " << dropped << " dropped of "
+              << TEST_PRODUCERS * count << std::endl;
+    result = false;
+  }
+  return result;
+}
+
+// ISR bursts from several pins at once. A burst that fits the queue is
+// delivered whole and in order, a longer stream only loses what didn't fit.
+// RtLog queues its records through the same ring
+bool Test_ConcurrentProducers(void) {
+  bool result = true;
+  for (uint32_t round = 0; round < 1000 && result; round++) {
+    uint32_t dropped = 0;
+    result &= RunConcurrentProducers(MAX_EVENT_QUEUE_SIZE / TEST_PRODUCERS, dropped);
+    if (dropped != 0) {
+      std::cout << "error: burst within the queue size dropped " << dropped << std::endl;
+      result = false;
+    }
+  }
+  uint32_t dropped = 0;
+  result &= RunConcurrentProducers(100000, dropped);
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+  return result;
+}
+
+int main() {
+  std::cout << "** test_input_gpio.cpp **" << std::endl;
+  bool tests[4] = {false, false, false, false};
+  tests[0] = Test_DoubleDownIsPerPin();
+  std::cout << tests[0] << std::endl;
+  tests[1] = Test_LongPressWhileHeld();
+  std::cout << tests[1] << std::endl;
+  tests[2] = Test_SimulatedPinEdges();
+  std::cout << tests[2] << std::endl;
+  tests[3] = Test_ConcurrentProducers();
+  std::cout << tests[3] << std::endl;
+
+  return 0;
+}
@@ -37,12 +37,72 @@ bool Test_SimpleMixerSummation(void) {
   return AreBlocksMatching(expected_results, mixed);
 }
 
+// N-way mix of the same four tracks in one pass, summed in track order
+bool Test_MixSourcesSummation(void) {
+  DataBlock mixed(5.0f), expected_results;
+  const float *sources[] = {
+    t1.GetBlockData(0).samples_.data(), t2.GetBlockData(0).samples_.data(),
+    t3.GetBlockData(1).samples_.data(), t4.GetBlockData(2).samples_.data()
+  };
+  for (uint32_t i = 0; i < SAMPLES_PER_BLOCK; i++) {
+    expected_results.samples_[i] = sources[0][i] + sources[1][i] + sources[2][i] + sources[3][i];
+  }
+
+  MixSources(sources, 4, mixed.samples_.data(), SAMPLES_PER_BLOCK);
+  bool result = AreBlocksMatching(expected_results, mixed);
+
+  // No sources is silence
+  MixSources(sources, 0, mixed.samples_.data(), SAMPLES_PER_BLOCK);
+  expected_results.samples_.fill(0.0f);
+  return result && AreBlocksMatching(expected_results, mixed);
+}
+
+// Every kernel the CPU supports must match the scalar kernel bit for bit
+// including partial blocks
+bool Test_KernelsMatchScalar(void) {
+  bool result = true;
+  DataBlock src1, src2, expected, mixed;
+  for (uint32_t i = 0; i < SAMPLES_PER_BLOCK; i++) {
+    src1.samples_[i] = 0.001f * i;
+    src2.samples_[i] = -0.37f + 0.0113f * i;
+    expected.samples_[i] = 0.25f - 0.002f * i;
+  }
+  mixed = expected;
+  MixerSelectKernel(MixKernelType::kScalar);
+  MixSamples(src1.samples_.data(), src2.samples_.data(), expected.samples_.data(), SAMPLES_PER_BLOCK - 5);
+
+  for (uint32_t k = 0; k < static_cast<uint32_t>(MixKernelType::kCount); k++) {
+    MixKernelType type = static_cast<MixKernelType>(k);
+    if (!MixerIsKernelSupported(type)) {
+      std::cout << "    kernel " << MixerGetKernelName(type) << " not supported" << std::endl;
+      continue;
+    }
+    if (!MixerSelectKernel(type)) {
+      std::cout << "error: kernel " << MixerGetKernelName(type) << " failed verification" << std::endl;
+      result = false;
+      continue;
+    }
+    DataBlock test = mixed;
+    MixSamples(src1.samples_.data(), src2.samples_.data(), test.samples_.data(), SAMPLES_PER_BLOCK - 5);
+    bool match = AreBlocksMatching(expected, test);
+    std::cout << "    kernel " << MixerGetKernelName(type) << " matched? " << match << std::endl;
+    result &= match;
+  }
+  MixerInit();
+  std::cout << "    selected kernel " << MixerGetKernelName(MixerGetKernel()) << std::endl;
+  return result;
+}
+
 // TODO Turn this into a test
 int main() {
   std::cout << "** test_mixer.cpp **" << std::endl;
   bool tests[5] = {false, false, false, false, false};
   tests[0] = Test_SimpleMixerSummation();
   std::cout << tests[0] << std::endl;
+  tests[1] = Test_KernelsMatchScalar();
+  std::cout << tests[1] << std::endl;
+  tests[2] = Test_MixSourcesSummation();
+  std::cout << tests[2] << std::endl;
  
   return 0;
 }
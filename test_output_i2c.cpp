@@ -0,0 +1,176 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "output_i2c.h"
+#include "hal_sim.h"
+
+// Register trace, one entry per burst write
+struct I2CTraceEntry {
+  uint8_t addr;
+  uint8_t reg;
+  std::vector<uint8_t> data;
+};
+
+static std::vector<I2CTraceEntry> trace;
+
+static void RecordWrite(void *context, uint8_t addr, uint8_t reg, const uint8_t *data, uint32_t length) {
+  trace.push_back({addr, reg, std::vector<uint8_t>(data, data + length)});
+}
+
+static void PrintTrace() {
+  for (auto &entry : trace) {
+    std::cout << "    " << std::hex << (int)entry.addr << " reg " << (int)entry.reg << ":";
+    for (auto b : entry.data) {
+      std::cout << " " << (int)b;
+    }
+    std::cout << std::dec << std::endl;
+  }
+}
+
+static bool IsSingleWrite(uint8_t addr, uint8_t reg, std::vector<uint8_t> data) {
+  if (trace.size() != 1) {
+    std::cout << "error: expected 1 write, got " << trace.size() << std::endl;
+    PrintTrace();
+    return false;
+  }
+  if (trace[0].addr != addr || trace[0].reg != reg || trace[0].data != data) {
+    std::cout << "error: unexpected write" << std::endl;
+    PrintTrace();
+    return false;
+  }
+  return true;
+}
+
+// Mute and unmute of a playing track program the green LED's blink registers
+// in one burst, the SX1509 keeps it blinking without further writes
+bool Test_MuteIsOneBurst(void) {
+  OutputI2C oi;
+  bool result = true;
+  oi.SetRegisterTraceHook(RecordWrite, nullptr);
+  oi.EnableTraceOnly();
+
+  // First flush writes every device in full
+  oi.SignalTrackPlayback(3);
+  oi.FlushPending();
+  trace.clear();
+
+  // Track 3 TOn 0x32, IOn 0x33, TOff 0x34 on the green expander
+  oi.SignalTrackMuted(3);
+  oi.FlushPending();
+  result &= IsSingleWrite(EXP1_ADDR, 0x32, {0x01, 0x0C, 0x0F});
+  trace.clear();
+
+  // Already muted, nothing to write
+  oi.SignalTrackMuted(3);
+  oi.FlushPending();
+  if (!trace.empty()) {
+    std::cout << "error: muted twice wrote to the bus" << std::endl;
+    PrintTrace();
+    result = false;
+  }
+  trace.clear();
+
+  oi.SignalTrackPlayback(3);
+  oi.FlushPending();
+  result &= IsSingleWrite(EXP1_ADDR, 0x32, {0x00, 0x0C, 0x00});
+  trace.clear();
+
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+  return result;
+}
+
+// Bytes on the bus for a write of length bytes, address and register included
+static uint32_t ExpectedCostNs(uint32_t length) {
+  return ((2 + length) * 9 + 2) * (1000000000 / SIM_I2C_DEFAULT_CLOCK_HZ);
+}
+
+// The driver runs against the simulated bus as on the Pi, with the worker
+// thread. Writes land in the device registers and are costed at the bus clock
+bool Test_SimulatedBus(void) {
+  bool result = HalSelectBackend(HalBackendType::kSim);
+  SimReset();
+  OutputI2C oi;
+  result &= oi.InitializeWiringPiI2C();
+  // SX1509 oscillator and LED driver enabled
+  if (SimI2CGetRegister(EXP0_ADDR, 0x1E) != 0x58 || SimI2CGetRegister(EXP1_ADDR, 0x21) != 0xFF) {
+    std::cout << "error: expanders not configured" << std::endl;
+    result = false;
+  }
+  SimI2CClearTrace();
+
+  // Track 3 playback, green LED intensity 0x33 on the green expander
+  oi.SignalTrackPlayback(3);
+  for (int wait = 0; wait < 1000 && SimI2CGetRegister(EXP1_ADDR, 0x33) != 0x0C; wait++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::vector<SimI2CTransaction> bus = SimI2CGetTrace();
+  if (SimI2CGetRegister(EXP1_ADDR, 0x33) != 0x0C || bus.empty()) {
+    std::cout << "error: playback LED not written" << std::endl;
+    result = false;
+  }
+  uint64_t total_ns = 0;
+  for (auto &transaction : bus) {
+    if (transaction.read || transaction.cost_ns != ExpectedCostNs(transaction.data.size())) {
+      std::cout << "error: reg " << std::hex << (int)transaction.reg << std::dec << " cost "
+                << transaction.cost_ns << "ns" << std::endl;
+      result = false;
+    }
+    total_ns += transaction.cost_ns;
+  }
+  if (total_ns != SimI2CGetBusTimeNs()) {
+    std::cout << "error: bus time " << SimI2CGetBusTimeNs() << "ns, expected " << total_ns << "ns" << std::endl;
+    result = false;
+  }
+
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+  return result;
+}
+
+// A device that fails the first full write is written in full on a later
+// flush, even registers that hold what committed was initialised to
+bool Test_FailedFirstWrite(void) {
+  bool result = HalSelectBackend(HalBackendType::kSim);
+  SimReset();
+  // Track 3's green intensity is left lit from before, off wants it 0
+  int fd = HalI2CSetup(EXP1_ADDR);
+  HalI2CWriteReg8(fd, 0x33, 0xAA);
+  SimI2CFailWrites(EXP1_ADDR, 0x33, 1);
+  OutputI2C oi;
+  result &= oi.InitializeWiringPiI2C();
+  if (SimI2CGetRegister(EXP1_ADDR, 0x33) != 0xAA) {
+    std::cout << "error: write to 0x33 didn't fail" << std::endl;
+    result = false;
+  }
+  // Any change flushes the green expander again
+  oi.SignalTrackPlayback(5);
+  for (int wait = 0; wait < 1000 && SimI2CGetRegister(EXP1_ADDR, 0x33) != 0x00; wait++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (SimI2CGetRegister(EXP1_ADDR, 0x33) != 0x00) {
+    std::cout << "error: failed register never rewritten" << std::endl;
+    result = false;
+  }
+
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+  return result;
+}
+
+int main() {
+  std::cout << "** test_output_i2c.cpp **" << std::endl;
+  bool tests[3] = {false, false, false};
+  tests[0] = Test_MuteIsOneBurst();
+  std::cout << tests[0] << std::endl;
+  tests[1] = Test_SimulatedBus();
+  std::cout << tests[1] << std::endl;
+  tests[2] = Test_FailedFirstWrite();
+  std::cout << tests[2] << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,165 @@
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include "rt_log.h"
+
+#define TEST_WRITERS 4
+
+// Flushes the log and returns what it printed, one entry per line
+static std::vector<std::string> FlushLines(RtLog &log) {
+  std::ostringstream captured;
+  std::streambuf *saved = std::cout.rdbuf(captured.rdbuf());
+  log.Flush();
+  std::cout.rdbuf(saved);
+  std::vector<std::string> lines;
+  std::istringstream printed(captured.str());
+  std::string line;
+  while (std::getline(printed, line)) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+// Writes past a full ring return straight away and are counted, the count is
+// printed after the records that fitted
+bool Test_FullRingDrops(void) {
+  RtLog log;
+  log.SetQueueOnly(true);
+  for (uint32_t i = 0; i < RT_LOG_RING_SIZE + 5; i++) {
+    log.Write("record %u", i);
+  }
+  bool result = true;
+  if (log.GetDropped() != 5) {
+    std::cout << "error: " << log.GetDropped() << " dropped" << std::endl;
+    result = false;
+  }
+  std::vector<std::string> lines = FlushLines(log);
+  if (lines.size() != RT_LOG_RING_SIZE + 1 || lines.back() != "RtLog: dropped 5 records") {
+    std::cout << "error: " << lines.size() << " lines, last "
+              << (lines.empty() ? "" : lines.back()) << std::endl;
+    result = false;
+  }
+  // The ring is free again and the drops were reported once
+  log.Write("after");
+  lines = FlushLines(log);
+  if (lines.size() != 1 || lines[0] != "after") {
+    std::cout << "error: " << lines.size() << " lines after the drops" << std::endl;
+    result = false;
+  }
+  return result;
+}
+
+// Queued records print in the order they were written, without a drain thread
+// a write prints straight away
+bool Test_FlushInOrder(void) {
+  RtLog log;
+  log.SetQueueOnly(true);
+  for (uint32_t i = 0; i < 10; i++) {
+    log.Write("record %u", i);
+  }
+  bool result = true;
+  std::vector<std::string> lines = FlushLines(log);
+  for (uint32_t i = 0; i < 10; i++) {
+    std::string expected = "record " + std::to_string(i);
+    if (i >= lines.size() || lines[i] != expected) {
+      std::cout << "error: line " << i << " is not " << expected << std::endl;
+      result = false;
+      break;
+    }
+  }
+  if (lines.size() != 10 || !FlushLines(log).empty()) {
+    std::cout << "error: " << lines.size() << " lines" << std::endl;
+    result = false;
+  }
+  log.SetQueueOnly(false);
+  std::ostringstream captured;
+  std::streambuf *saved = std::cout.rdbuf(captured.rdbuf());
+  log.Write("now");
+  std::cout.rdbuf(saved);
+  if (captured.str() != "now\n") {
+    std::cout << "error: write printed \"" << captured.str() << "\"" << std::endl;
+    result = false;
+  }
+  return result;
+}
+
+// A line longer than a record is cut to fit, the terminator included
+bool Test_Truncation(void) {
+  RtLog log;
+  log.SetQueueOnly(true);
+  std::string line;
+  for (uint32_t i = 0; i < 3 * RT_LOG_RECORD_SIZE; i++) {
+    line += (char)('a' + i % 26);
+  }
+  log.Write("%s", line.c_str());
+  std::vector<std::string> lines = FlushLines(log);
+  if (lines.size() != 1 || lines[0] != line.substr(0, RT_LOG_RECORD_SIZE - 1)) {
+    std::cout << "error: " << lines.size() << " lines, first "
+              << (lines.empty() ? 0 : lines[0].size()) << " characters" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Writers start together and write until the ring is just full. Nothing is
+// dropped and each writer's records come out in the order it wrote them
+bool Test_ConcurrentWriters(void) {
+  const uint32_t kCount = RT_LOG_RING_SIZE / TEST_WRITERS;
+  for (uint32_t round = 0; round < 200; round++) {
+    RtLog log;
+    log.SetQueueOnly(true);
+    std::atomic<bool> start(false);
+    std::vector<std::thread> writers;
+    for (uint32_t w = 0; w < TEST_WRITERS; w++) {
+      writers.push_back(std::thread([&log, &start, w, kCount]() {
+        while (!start.load()) {}
+        for (uint32_t i = 0; i < kCount; i++) {
+          log.Write("%u %u", w, i);
+        }
+      }));
+    }
+    start.store(true);
+    for (auto &writer : writers) {
+      writer.join();
+    }
+    if (log.GetDropped() != 0) {
+      std::cout << "error: round " << round << ", " << log.GetDropped() << " dropped" << std::endl;
+      return false;
+    }
+    std::vector<std::string> lines = FlushLines(log);
+    uint32_t next[TEST_WRITERS] = {0};
+    for (auto &line : lines) {
+      uint32_t w, i;
+      if (sscanf(line.c_str(), "%u %u", &w, &i) != 2 || w >= TEST_WRITERS || i != next[w]) {
+        std::cout << "error: round " << round << ", line \"" << line << "\" out of order" << std::endl;
+        return false;
+      }
+      next[w]++;
+    }
+    if (lines.size() != RT_LOG_RING_SIZE) {
+      std::cout << "error: round " << round << ", " << lines.size() << " lines" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  std::cout << "** test_rt_log.cpp **" << std::endl;
+  bool tests[4] = {false};
+  tests[0] = Test_FullRingDrops();
+  tests[1] = Test_FlushInOrder();
+  tests[2] = Test_Truncation();
+  tests[3] = Test_ConcurrentWriters();
+  for (auto result : tests) {
+    if (!result) {
+      std::cout << "---> TEST FAILED" << std::endl;
+    }
+    std::cout << result << std::endl;
+  }
+  return 0;
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <array>
 #include <iostream>
 #include <iterator>
@@ -459,13 +460,13 @@ bool Test_SingleTrackRecordingToPlaybackIndexes(TrackManager &tm) {
   }
 
   DisplayIndexes(tm, 0);
-  exp.gmei = 2;
-  exp.t_ei = 2;
+  exp.gmei = 1;
+  exp.t_ei = 1;
   exp.gmci = 0;
   exp.t_ci = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
-  std::cout << "    T0 process 3x, 0->1->2->0->1->2" << std::endl;
+  std::cout << "    T0 process 5x, 0->1->0->1->0->1" << std::endl;
   tm.StateProcess(0);
   DisplayIndexes(tm, 0);
   tm.StateProcess(0);
@@ -477,10 +478,10 @@ bool Test_SingleTrackRecordingToPlaybackIndexes(TrackManager &tm) {
   tm.StateProcess(0);
   DisplayIndexes(tm, 0);
 
-  exp.gmei = 2;
-  exp.t_ei = 2;
-  exp.gmci = 2;
-  exp.t_ci = 2;
+  exp.gmei = 1;
+  exp.t_ei = 1;
+  exp.gmci = 1;
+  exp.t_ci = 1;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
   std::cout << "    T0 P -> Off" << std::endl;
@@ -562,10 +563,10 @@ bool Test_TrackRecordingNewTrackStartsRecordingIndexes(TrackManager &tm) {
 
   // Because T0 when to playback first, this will reset master current index to 0
   exp.gmci = 0;
-  exp.gmei = 2;
+  exp.gmei = 1;
   // T0
   exp.t_ci = 0;
-  exp.t_ei = 2;
+  exp.t_ei = 1;
   exp.t_si = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
@@ -580,10 +581,10 @@ bool Test_TrackRecordingNewTrackStartsRecordingIndexes(TrackManager &tm) {
   tm.StateProcess(1);
 
   exp.gmci = 2;
-  exp.gmei = 2;
+  exp.gmei = 1;
   // T0
   exp.t_ci = 2;
-  exp.t_ei = 2;
+  exp.t_ei = 1;
   exp.t_si = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
@@ -609,7 +610,7 @@ bool Test_TrackRecordingNewTrackStartsRecordingIndexes(TrackManager &tm) {
   }
 
   exp.gmci = 0;
-  exp.gmei = 2;
+  exp.gmei = 1;
   // T0
   exp.t_ci = 0;
   exp.t_ei = 0;
@@ -618,7 +619,7 @@ bool Test_TrackRecordingNewTrackStartsRecordingIndexes(TrackManager &tm) {
 
   // T1
   exp.t_ci = 0;
-  exp.t_ei = 2;
+  exp.t_ei = 1;
   exp.t_si = 0;
   if (!VerifyIndexes(tm, exp, 1)) { return false; }
 
@@ -694,8 +695,8 @@ bool Test_TrackPlaybackNewTrackStartsRecordingIndexes(TrackManager &tm) {
   }
 
   DisplayIndexes(tm, 0);
-  exp.gmei = 2;
-  exp.t_ei = 2;
+  exp.gmei = 1;
+  exp.t_ei = 1;
   exp.gmci = 0;
   exp.t_ci = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
@@ -703,10 +704,10 @@ bool Test_TrackPlaybackNewTrackStartsRecordingIndexes(TrackManager &tm) {
   // Play 1 block then start recording on T1
   tm.StateProcess(0);
 
-  exp.gmei = 2;
+  exp.gmei = 1;
   exp.gmci = 1;
   exp.t_ci = 1;
-  exp.t_ei = 2;
+  exp.t_ei = 1;
   exp.t_si = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
@@ -726,10 +727,10 @@ bool Test_TrackPlaybackNewTrackStartsRecordingIndexes(TrackManager &tm) {
   }
 
   exp.gmci = 1;
-  exp.gmei = 2;
+  exp.gmei = 1;
   // T0
   exp.t_ci = 1;
-  exp.t_ei = 2;
+  exp.t_ei = 1;
   exp.t_si = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
@@ -747,10 +748,10 @@ bool Test_TrackPlaybackNewTrackStartsRecordingIndexes(TrackManager &tm) {
   DisplayIndexes(tm, 1);
 
   exp.gmci = 3;
-  exp.gmei = 2;
+  exp.gmei = 1;
   // T0
   exp.t_ci = 3;
-  exp.t_ei = 2;
+  exp.t_ei = 1;
   exp.t_si = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
@@ -771,18 +772,18 @@ bool Test_TrackPlaybackNewTrackStartsRecordingIndexes(TrackManager &tm) {
   DisplayIndexes(tm, 0);
   DisplayIndexes(tm, 1);
   exp.gmci = 0;
-  exp.gmei = 3;
+  exp.gmei = 2;
   // T0
   exp.t_ci = 3; // T1 to play does no reset T0's current index -- PerformMixdown
   // does not use track's current index, uses master current index unless in repeat
   // so this is to be expected, playback doesn't use it, only repeat does
-  exp.t_ei = 2;
+  exp.t_ei = 1;
   exp.t_si = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
   // T1
   exp.t_ci = 0;
-  exp.t_ei = 3;
+  exp.t_ei = 2;
   exp.t_si = 1;
   if (!VerifyIndexes(tm, exp, 1)) { return false; }
 
@@ -816,8 +817,8 @@ bool Test_TrackPlaybackNewTrackStartsRecordingIndexes(TrackManager &tm) {
     return result;
   }
 
-  exp.gmci = 0;
-  exp.gmei = 3;
+  exp.gmci = 1;
+  exp.gmei = 2;
   // T0
   exp.t_ci = 0;
   exp.t_ei = 0;
@@ -826,7 +827,7 @@ bool Test_TrackPlaybackNewTrackStartsRecordingIndexes(TrackManager &tm) {
 
   // T1
   exp.t_ci = 4;
-  exp.t_ei = 3;
+  exp.t_ei = 2;
   exp.t_si = 1;
   if (!VerifyIndexes(tm, exp, 1)) { return false; }
 
@@ -912,8 +913,8 @@ bool Test_TrackPlaybackNewTrackStartsRecordingThenRepeatsIndexes(TrackManager &t
   }
 
   DisplayIndexes(tm, 0);
-  exp.gmei = 2;
-  exp.t_ei = 2;
+  exp.gmei = 1;
+  exp.t_ei = 1;
   exp.gmci = 0;
   exp.t_ci = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
@@ -922,10 +923,10 @@ bool Test_TrackPlaybackNewTrackStartsRecordingThenRepeatsIndexes(TrackManager &t
   std::cout << "    Process t0 in play" << std::endl;
   tm.StateProcess(0);
 
-  exp.gmei = 2;
+  exp.gmei = 1;
   exp.gmci = 1;
   exp.t_ci = 1;
-  exp.t_ei = 2;
+  exp.t_ei = 1;
   exp.t_si = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
@@ -945,10 +946,10 @@ bool Test_TrackPlaybackNewTrackStartsRecordingThenRepeatsIndexes(TrackManager &t
   }
 
   exp.gmci = 1;
-  exp.gmei = 2;
+  exp.gmei = 1;
   // T0
   exp.t_ci = 1;
-  exp.t_ei = 2;
+  exp.t_ei = 1;
   exp.t_si = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
@@ -966,10 +967,10 @@ bool Test_TrackPlaybackNewTrackStartsRecordingThenRepeatsIndexes(TrackManager &t
   DisplayIndexes(tm, 1);
 
   exp.gmci = 3;
-  exp.gmei = 2;
+  exp.gmei = 1;
   // T0
   exp.t_ci = 3;
-  exp.t_ei = 2;
+  exp.t_ei = 1;
   exp.t_si = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
@@ -990,18 +991,18 @@ bool Test_TrackPlaybackNewTrackStartsRecordingThenRepeatsIndexes(TrackManager &t
   DisplayIndexes(tm, 0);
   DisplayIndexes(tm, 1);
   exp.gmci = 0;
-  exp.gmei = 3;
+  exp.gmei = 2;
   // T0
   exp.t_ci = 3; // T1 to play does no reset T0's current index -- PerformMixdown
   // does not use track's current index, uses master current index unless in repeat
   // so this is to be expected, playback doesn't use it, only repeat does
-  exp.t_ei = 2;
+  exp.t_ei = 1;
   exp.t_si = 0;
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
   // T1
   exp.t_ci = 1; // repeat - CI is sync'd with SI not MCI
-  exp.t_ei = 3;
+  exp.t_ei = 2;
   exp.t_si = 1;
   if (!VerifyIndexes(tm, exp, 1)) { return false; }
 
@@ -1035,8 +1036,8 @@ bool Test_TrackPlaybackNewTrackStartsRecordingThenRepeatsIndexes(TrackManager &t
     return result;
   }
 
-  exp.gmci = 0;
-  exp.gmei = 3;
+  exp.gmci = 1;
+  exp.gmei = 2;
   // T0
   exp.t_ci = 0;
   exp.t_ei = 0;
@@ -1044,8 +1045,8 @@ bool Test_TrackPlaybackNewTrackStartsRecordingThenRepeatsIndexes(TrackManager &t
   if (!VerifyIndexes(tm, exp, 0)) { return false; }
 
   // T1
-  exp.t_ci = 2;
-  exp.t_ei = 3;
+  exp.t_ci = 1;
+  exp.t_ei = 2;
   exp.t_si = 1;
   if (!VerifyIndexes(tm, exp, 1)) { return false; }
 
@@ -1177,6 +1178,470 @@ bool Test_RecordingSingleTrackWithData(TrackManager &tm) {
   return true;
 }
 
+// Same as above but recording from and mixing into the caller's buffers
+// directly, as done with the JACK port buffers
+bool Test_RecordingSingleTrackZeroCopy(TrackManager &tm) {
+  std::cout << std::endl << "** Test Recording zero-copy - state machine **" << std::endl;
+
+  bool result = tm.tracks.at(0).IsTrackOff();
+  if (!result) {
+    std::cout << "error: track 0 not off" << std::endl;
+    return result;
+  }
+
+  float in[SAMPLES_PER_BLOCK];
+  float out[SAMPLES_PER_BLOCK];
+  for (int idx = 0; idx < SAMPLES_PER_BLOCK; idx++) {
+    in[idx] = 0.5f + idx;
+    out[idx] = -1.0f;
+  }
+
+  std::cout << "    Record track 0 **" << std::endl;
+  tm.HandleDownEvent(0);
+  uint32_t block = tm.tracks.at(0).GetCurrentIndex();
+  tm.StateProcess(0, in, out);
+
+  for (int idx = 0; idx < SAMPLES_PER_BLOCK; idx++) {
+    if (out[idx] != in[idx] || tm.tracks.at(0).GetBlockData(block).samples_[idx] != in[idx]) {
+      std::cout << "error: out[" << idx << "]:" << out[idx] << " =/= " << " in[" << idx << "]:" << in[idx] << std::endl;
+      return false;
+    }
+  }
+
+  std::cout << "    Overdub track 0 **" << std::endl;
+  tm.HandleDownEvent(0); // play
+  tm.HandleDownEvent(0); // overdub
+  tm.tracks.at(0).SetCurrentIndex(block);
+  tm.SetMasterCurrentIndex(block);
+  tm.StateProcess(0, in, out);
+  for (int idx = 0; idx < SAMPLES_PER_BLOCK; idx++) {
+    if (tm.tracks.at(0).GetBlockData(block).samples_[idx] != in[idx] + in[idx]) {
+      std::cout << "error: overdub block[" << idx << "]:" << tm.tracks.at(0).GetBlockData(block).samples_[idx] << std::endl;
+      return false;
+    }
+  }
+
+  // Output must be silence when there is no mixdown
+  tm.HandleDownEvent(0);
+  tm.HandleDoubleDownEvent(0);
+  result = tm.tracks.at(0).IsTrackOff();
+  if (!result) {
+    std::cout << "error: track 0 not off" << std::endl;
+    return result;
+  }
+  tm.StateProcess(0, in, out);
+  for (int idx = 0; idx < SAMPLES_PER_BLOCK; idx++) {
+    if (out[idx] != 0.0f) {
+      std::cout << "error: out[" << idx << "]:" << out[idx] << " not silent" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// JACK period sizes other than SAMPLES_PER_BLOCK - record with 64 frame periods
+// and play back with 256 frame periods
+bool Test_RecordingSingleTrackOddPeriods(TrackManager &tm) {
+  std::cout << std::endl << "** Test Recording odd period sizes - state machine **" << std::endl;
+
+  bool result = tm.tracks.at(0).IsTrackOff();
+  if (!result) {
+    std::cout << "error: track 0 not off" << std::endl;
+    return result;
+  }
+
+  const uint32_t kBlocks = 4;
+  const uint32_t kSamples = kBlocks * SAMPLES_PER_BLOCK;
+  float in[kSamples];
+  float out[kSamples];
+  for (uint32_t idx = 0; idx < kSamples; idx++) {
+    in[idx] = 0.25f + idx;
+    out[idx] = -1.0f;
+  }
+
+  std::cout << "    Record track 0 with 64 frame periods **" << std::endl;
+  tm.HandleDownEvent(0);
+  uint32_t start_block = tm.tracks.at(0).GetCurrentIndex();
+  for (uint32_t offset = 0; offset < kSamples; offset += 64) {
+    tm.ProcessFrames(0, in + offset, out + offset, 64);
+  }
+  if (tm.tracks.at(0).GetCurrentIndex() != start_block + kBlocks) {
+    std::cout << "error: current index " << tm.tracks.at(0).GetCurrentIndex()
+              << " expected " << start_block + kBlocks << std::endl;
+    return false;
+  }
+  for (uint32_t idx = 0; idx < kSamples; idx++) {
+    float sample = tm.tracks.at(0).GetBlockData(start_block + idx / SAMPLES_PER_BLOCK).samples_[idx % SAMPLES_PER_BLOCK];
+    if (sample != in[idx]) {
+      std::cout << "error: block sample " << idx << ":" << sample << " =/= " << in[idx] << std::endl;
+      return false;
+    }
+  }
+
+  std::cout << "    Play track 0 with 256 frame periods **" << std::endl;
+  tm.HandleDownEvent(0);
+  tm.tracks.at(0).SetCurrentIndex(start_block);
+  tm.SetMasterCurrentIndex(start_block);
+  float silence[kSamples] = {};
+  for (uint32_t offset = 0; offset < kSamples; offset += 256) {
+    tm.ProcessFrames(0, silence + offset, out + offset, 256, false);
+  }
+  for (uint32_t idx = 0; idx < kSamples; idx++) {
+    if (out[idx] != in[idx]) {
+      std::cout << "error: out[" << idx << "]:" << out[idx] << " =/= " << " in[" << idx << "]:" << in[idx] << std::endl;
+      return false;
+    }
+  }
+
+  tm.HandleDoubleDownEvent(0);
+  return tm.tracks.at(0).IsTrackOff();
+}
+
+// Processes blocks until track_number is in the wanted state, returns the master
+// index at the start of the block it changed in, MAX_BLOCK_COUNT if it didn't
+static uint32_t ProcessUntilTrackState(TrackManager &tm, uint32_t track_number, bool recording,
+                                       float *in, float *out) {
+  for (uint32_t block = 0; block < 32; block++) {
+    uint32_t index = tm.GetMasterCurrentIndex();
+    tm.ProcessFrames(track_number, in, out, SAMPLES_PER_BLOCK);
+    if (tm.tracks.at(track_number).IsTrackInRecord() == recording) {
+      return index;
+    }
+  }
+  return MAX_BLOCK_COUNT;
+}
+
+bool Test_QuantizedLaunch(TrackManager &tm) {
+  std::cout << std::endl << "** Test quantized launch - state machine **" << std::endl;
+  float in[SAMPLES_PER_BLOCK] = {};
+  float out[SAMPLES_PER_BLOCK];
+  tm.SetQuantize(1);
+
+  std::cout << "    First recording sets the loop, not quantized" << std::endl;
+  tm.HandleDownEvent(0);
+  for (uint32_t block = 0; block < 8; block++) {
+    tm.ProcessFrames(0, in, out, SAMPLES_PER_BLOCK);
+  }
+  tm.HandleDownEvent(0);
+  if (!tm.tracks.at(0).IsTrackInPlayback() || tm.GetQuantizedEventCount() != 0) {
+    std::cout << "error: track 0 not in playback" << std::endl;
+    return false;
+  }
+  uint32_t loop_end = tm.GetMasterEndIndex();
+  std::cout << "    loop end index " << loop_end << std::endl;
+
+  std::cout << "    Record track 1 starts when the loop wraps" << std::endl;
+  for (uint32_t block = 0; block < 3; block++) {
+    tm.ProcessFrames(0, in, out, SAMPLES_PER_BLOCK);
+  }
+  tm.HandleDownEvent(1);
+  if (!tm.tracks.at(1).IsTrackOff() || tm.GetQuantizedEventCount() != 1) {
+    std::cout << "error: track 1 event not queued" << std::endl;
+    return false;
+  }
+  uint32_t index = ProcessUntilTrackState(tm, 1, true, in, out);
+  if (index != 0) {
+    std::cout << "error: track 1 started recording at index " << index << std::endl;
+    return false;
+  }
+
+  std::cout << "    Stop track 1 on a quarter of the loop" << std::endl;
+  tm.SetQuantize(4);
+  uint32_t step = (loop_end + 1) / 4;
+  tm.ProcessFrames(1, in, out, SAMPLES_PER_BLOCK);
+  if (tm.GetMasterCurrentIndex() % step == 0) {
+    tm.ProcessFrames(1, in, out, SAMPLES_PER_BLOCK);
+  }
+  tm.HandleDownEvent(1);
+  index = ProcessUntilTrackState(tm, 1, false, in, out);
+  if (index % step != 0 || !tm.tracks.at(1).IsTrackInPlayback()) {
+    std::cout << "error: track 1 stopped at index " << index << ", step " << step << std::endl;
+    return false;
+  }
+  std::cout << "    stopped at index " << index << std::endl;
+
+  std::cout << "    Event with the queue full is dropped, not applied early" << std::endl;
+  for (uint32_t e = 0; e < QUANTIZE_QUEUE_SIZE; e++) {
+    tm.HandleShortPulseEvent(2);
+  }
+  uint32_t dropped = tm.GetDroppedQuantizedEvents();
+  tm.HandleDownEvent(2);
+  if (!tm.tracks.at(2).IsTrackOff() || tm.GetQuantizedEventCount() != QUANTIZE_QUEUE_SIZE ||
+      tm.GetDroppedQuantizedEvents() != dropped + 1) {
+    std::cout << "error: event with the queue full was not dropped" << std::endl;
+    return false;
+  }
+  for (uint32_t block = 0; block < 32 && tm.GetQuantizedEventCount() != 0; block++) {
+    tm.ProcessFrames(1, in, out, SAMPLES_PER_BLOCK);
+  }
+  if (!tm.tracks.at(2).IsTrackOff() || tm.GetQuantizedEventCount() != 0) {
+    std::cout << "error: queued events not applied or track 2 started" << std::endl;
+    return false;
+  }
+
+  tm.SetQuantize(0);
+  tm.HandleDoubleDownEvent(1);
+  tm.HandleDoubleDownEvent(0);
+  return tm.tracks.at(0).IsTrackOff() && tm.tracks.at(1).IsTrackOff();
+}
+
+// Recording stopped 50 frames into a block loops at that sample, not at the end
+// of the block
+bool Test_SampleAccurateLoop(TrackManager &tm) {
+  std::cout << std::endl << "** Test sample accurate loop length - state machine **" << std::endl;
+
+  bool result = tm.tracks.at(0).IsTrackOff();
+  if (!result) {
+    std::cout << "error: track 0 not off" << std::endl;
+    return result;
+  }
+
+  const uint32_t kLoop = 4 * SAMPLES_PER_BLOCK + 50;
+  const uint32_t kPlay = 3 * kLoop;
+  float in[kLoop];
+  float out[kPlay];
+  float silence[kPlay] = {};
+  for (uint32_t idx = 0; idx < kLoop; idx++) {
+    in[idx] = 0.5f + idx;
+  }
+
+  std::cout << "    Record track 0 for " << kLoop << " frames **" << std::endl;
+  tm.HandleDownEvent(0);
+  for (uint32_t offset = 0; offset < kLoop; offset += SAMPLES_PER_BLOCK) {
+    tm.ProcessFrames(0, in + offset, out, std::min<uint32_t>(SAMPLES_PER_BLOCK, kLoop - offset));
+  }
+  tm.HandleDownEvent(0);
+  if (tm.GetMasterEndIndex() != 4 || tm.GetMasterEndOffset() != 50) {
+    std::cout << "error: loop end " << tm.GetMasterEndIndex() << ":" << tm.GetMasterEndOffset()
+              << " expected 4:50" << std::endl;
+    return false;
+  }
+
+  std::cout << "    Play track 0 three times round **" << std::endl;
+  for (uint32_t offset = 0; offset < kPlay; offset += SAMPLES_PER_BLOCK) {
+    tm.ProcessFrames(0, silence + offset, out + offset,
+                     std::min<uint32_t>(SAMPLES_PER_BLOCK, kPlay - offset), false);
+  }
+  for (uint32_t idx = 0; idx < kPlay; idx++) {
+    if (out[idx] != in[idx % kLoop]) {
+      std::cout << "error: out[" << idx << "]:" << out[idx] << " =/= " << " in[" << idx % kLoop
+                << "]:" << in[idx % kLoop] << std::endl;
+      return false;
+    }
+  }
+
+  tm.HandleDoubleDownEvent(0);
+  return tm.tracks.at(0).IsTrackOff() && tm.GetMasterEndOffset() == 0;
+}
+
+// Recording stopped on a block boundary loops at that boundary, the block that
+// was about to be recorded isn't part of the loop
+bool Test_BoundaryStopLoop(TrackManager &tm) {
+  std::cout << std::endl << "** Test loop stopped on a block boundary - state machine **" << std::endl;
+
+  bool result = tm.tracks.at(0).IsTrackOff();
+  if (!result) {
+    std::cout << "error: track 0 not off" << std::endl;
+    return result;
+  }
+
+  const uint32_t kLoop = 4 * SAMPLES_PER_BLOCK;
+  const uint32_t kPlay = 3 * kLoop;
+  float in[kLoop];
+  float out[kPlay];
+  float silence[kPlay] = {};
+  for (uint32_t idx = 0; idx < kLoop; idx++) {
+    in[idx] = 0.5f + idx;
+  }
+
+  std::cout << "    Record track 0 for " << kLoop << " frames **" << std::endl;
+  tm.HandleDownEvent(0);
+  for (uint32_t offset = 0; offset < kLoop; offset += SAMPLES_PER_BLOCK) {
+    tm.ProcessFrames(0, in + offset, out, SAMPLES_PER_BLOCK);
+  }
+  tm.HandleDownEvent(0);
+  if (tm.GetMasterEndIndex() != 3 || tm.GetMasterEndOffset() != 0) {
+    std::cout << "error: loop end " << tm.GetMasterEndIndex() << ":" << tm.GetMasterEndOffset()
+              << " expected 3:0" << std::endl;
+    return false;
+  }
+
+  std::cout << "    Play track 0 three times round **" << std::endl;
+  for (uint32_t offset = 0; offset < kPlay; offset += SAMPLES_PER_BLOCK) {
+    tm.ProcessFrames(0, silence + offset, out + offset, SAMPLES_PER_BLOCK, false);
+  }
+  for (uint32_t idx = 0; idx < kPlay; idx++) {
+    if (out[idx] != in[idx % kLoop]) {
+      std::cout << "error: out[" << idx << "]:" << out[idx] << " =/= " << " in[" << idx % kLoop
+                << "]:" << in[idx % kLoop] << std::endl;
+      return false;
+    }
+  }
+
+  tm.HandleDoubleDownEvent(0);
+  return tm.tracks.at(0).IsTrackOff();
+}
+
+// Checks out against gain(i) * level over count samples
+static bool IsRamp(const float *out, uint32_t count, float start, float step, const char *name) {
+  for (uint32_t i = 0; i < count; i++) {
+    float expected = start + step * i;
+    if (out[i] != expected) {
+      std::cout << "error: " << name << " out[" << i << "]:" << out[i] << " =/= " << expected << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Mute and unmute fade over the ramp length, the loop seam dips to silence
+bool Test_GainRamps(TrackManager &tm) {
+  std::cout << std::endl << "** Test gain ramps - state machine **" << std::endl;
+
+  bool result = tm.tracks.at(0).IsTrackOff();
+  if (!result) {
+    std::cout << "error: track 0 not off" << std::endl;
+    return result;
+  }
+
+  const uint32_t kRamp = 2 * SAMPLES_PER_BLOCK;
+  float ones[SAMPLES_PER_BLOCK];
+  float silence[SAMPLES_PER_BLOCK] = {};
+  float out[3 * SAMPLES_PER_BLOCK];
+  std::fill(ones, ones + SAMPLES_PER_BLOCK, 1.0f);
+  tm.SetGainRampLength(kRamp);
+
+  std::cout << "    Record 7.5 blocks on track 0 **" << std::endl;
+  tm.HandleDownEvent(0);
+  for (uint32_t block = 0; block < 7; block++) {
+    tm.ProcessFrames(0, ones, out, SAMPLES_PER_BLOCK);
+  }
+  tm.ProcessFrames(0, ones, out, SAMPLES_PER_BLOCK / 2);
+  tm.HandleDownEvent(0);
+  tm.ProcessFrames(0, silence, out, SAMPLES_PER_BLOCK);
+
+  std::cout << "    Mute fades out **" << std::endl;
+  tm.HandleMuteUnmuteTracks(0x1);
+  for (uint32_t block = 0; block < 3; block++) {
+    tm.ProcessFrames(0, silence, out + block * SAMPLES_PER_BLOCK, SAMPLES_PER_BLOCK, false);
+  }
+  result = IsRamp(out, kRamp, 1.0f, -1.0f / kRamp, "mute") &&
+           IsRamp(out + kRamp, SAMPLES_PER_BLOCK, 0.0f, 0.0f, "muted");
+
+  std::cout << "    Unmute fades in **" << std::endl;
+  tm.HandleMuteUnmuteTracks(0x0);
+  for (uint32_t block = 0; block < 3; block++) {
+    tm.ProcessFrames(0, silence, out + block * SAMPLES_PER_BLOCK, SAMPLES_PER_BLOCK, false);
+  }
+  result = result && IsRamp(out, kRamp, 0.0f, 1.0f / kRamp, "unmute") &&
+           IsRamp(out + kRamp, SAMPLES_PER_BLOCK, 1.0f, 0.0f, "unmuted");
+  if (result && tm.GetFadingTracks() != 0) {
+    std::cout << "error: fades still running " << tm.GetFadingTracks() << std::endl;
+    result = false;
+  }
+
+  // The loop ends half way into block 7, the next block starts with the seam
+  std::cout << "    Seam fades out and in **" << std::endl;
+  const uint32_t kSeam = 32;
+  const uint32_t kEnd = SAMPLES_PER_BLOCK / 2;
+  tm.SetLoopSeamFade(kSeam);
+  bool seen_seam = false;
+  for (uint32_t block = 0; result && !seen_seam && block < 10; block++) {
+    seen_seam = tm.GetMasterCurrentIndex() == tm.GetMasterEndIndex();
+    tm.ProcessFrames(0, silence, out, SAMPLES_PER_BLOCK, false);
+  }
+  if (result && !seen_seam) {
+    std::cout << "error: loop didn't wrap" << std::endl;
+    result = false;
+  }
+  result = result && IsRamp(out, kEnd - kSeam, 1.0f, 0.0f, "before seam") &&
+           IsRamp(out + kEnd - kSeam, kSeam, 1.0f, -1.0f / kSeam, "seam out") &&
+           IsRamp(out + kEnd, kSeam, 0.0f, 1.0f / kSeam, "seam in") &&
+           IsRamp(out + kEnd + kSeam, SAMPLES_PER_BLOCK - kEnd - kSeam, 1.0f, 0.0f, "after seam");
+  tm.SetLoopSeamFade(0);
+
+  // Muted 16 frames before the loop end, the tail carries on from the start
+  std::cout << "    Mute at the loop end fades out over the loop start **" << std::endl;
+  const uint32_t kStep = 16;
+  for (uint32_t frames = 0; frames < 20 * SAMPLES_PER_BLOCK; frames += kStep) {
+    if (tm.GetMasterCurrentIndex() == tm.GetMasterEndIndex() &&
+        tm.GetMasterCurrentOffset() == kEnd - kStep) {
+      break;
+    }
+    tm.ProcessFrames(0, silence, out, kStep, false);
+  }
+  tm.HandleMuteUnmuteTracks(0x1);
+  for (uint32_t block = 0; block < 3; block++) {
+    tm.ProcessFrames(0, silence, out + block * SAMPLES_PER_BLOCK, SAMPLES_PER_BLOCK, false);
+  }
+  result = result && IsRamp(out, kRamp, 1.0f, -1.0f / kRamp, "mute at loop end") &&
+           IsRamp(out + kRamp, SAMPLES_PER_BLOCK, 0.0f, 0.0f, "muted at loop end");
+  tm.HandleMuteUnmuteTracks(0x0);
+  tm.SetGainRampLength(GAIN_RAMP_DEFAULT_SAMPLES);
+
+  tm.HandleDoubleDownEvent(0);
+  return result && tm.tracks.at(0).IsTrackOff();
+}
+
+// Gains set through MixParameters ramp over the ramp length to their new value
+bool Test_TrackGainAndPan(TrackManager &tm) {
+  std::cout << std::endl << "** Test track gain and pan - state machine **" << std::endl;
+
+  bool result = tm.tracks.at(0).IsTrackOff();
+  if (!result) {
+    std::cout << "error: track 0 not off" << std::endl;
+    return result;
+  }
+
+  MixParameters parameters;
+  const uint32_t kRamp = 2 * SAMPLES_PER_BLOCK;
+  float ones[SAMPLES_PER_BLOCK];
+  float silence[kRamp + SAMPLES_PER_BLOCK] = {};
+  float out[kRamp + SAMPLES_PER_BLOCK];
+  std::fill(ones, ones + SAMPLES_PER_BLOCK, 1.0f);
+  tm.SetGainRampLength(kRamp);
+  tm.SetMixParameters(&parameters, MixChannel::kLeft);
+  // hard left is unity on the left
+  parameters.SetTrackPan(0, -1.0f);
+
+  std::cout << "    Record 8 blocks on track 0 **" << std::endl;
+  tm.HandleDownEvent(0);
+  for (uint32_t block = 0; block < 8; block++) {
+    tm.ProcessFrames(0, ones, out, SAMPLES_PER_BLOCK);
+  }
+  tm.HandleDownEvent(0);
+  tm.ProcessFrames(0, silence, out, SAMPLES_PER_BLOCK, false);
+  result = IsRamp(out, SAMPLES_PER_BLOCK, 1.0f, 0.0f, "unity");
+
+  // Changes ramp over kRamp whichever segments they fall in
+  std::cout << "    Track gain 0.5 **" << std::endl;
+  parameters.SetTrackGain(0, 0.5f);
+  tm.ProcessFrames(0, silence, out, kRamp + SAMPLES_PER_BLOCK, false);
+  result = result && IsRamp(out, kRamp, 1.0f, -0.5f / kRamp, "gain ramp") &&
+           IsRamp(out + kRamp, SAMPLES_PER_BLOCK, 0.5f, 0.0f, "gain");
+
+  std::cout << "    Master gain 2, first segment 1 frame **" << std::endl;
+  parameters.SetMasterGain(2.0f);
+  tm.ProcessFrames(0, silence, out, 1, false);
+  tm.ProcessFrames(0, silence, out + 1, kRamp + SAMPLES_PER_BLOCK - 1, false);
+  result = result && IsRamp(out, kRamp, 0.5f, 0.5f / kRamp, "master ramp") &&
+           IsRamp(out + kRamp, SAMPLES_PER_BLOCK, 1.0f, 0.0f, "master");
+
+  std::cout << "    Pan hard right **" << std::endl;
+  parameters.SetTrackPan(0, 1.0f);
+  tm.ProcessFrames(0, silence, out, kRamp + SAMPLES_PER_BLOCK, false);
+  result = result && IsRamp(out, kRamp, 1.0f, -1.0f / kRamp, "pan ramp") &&
+           IsRamp(out + kRamp, SAMPLES_PER_BLOCK, 0.0f, 0.0f, "panned");
+  if (parameters.GetChannelGain(MixChannel::kRight, 0) != 1.0f) {
+    std::cout << "error: right gain " << parameters.GetChannelGain(MixChannel::kRight, 0) << std::endl;
+    result = false;
+  }
+
+  tm.SetMixParameters(nullptr);
+  tm.HandleDoubleDownEvent(0);
+  return result && tm.tracks.at(0).IsTrackOff();
+}
+
 int main() {
   std::cout << "** test_state_machine.cpp **" << std::endl;
 #if 0
@@ -1225,6 +1690,41 @@ int main() {
     std::cout << "---> TEST FAILED" << std::endl;
   }
 
+  result = Test_RecordingSingleTrackZeroCopy(tm);
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+
+  result = Test_RecordingSingleTrackOddPeriods(tm);
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+
+  result = Test_QuantizedLaunch(tm);
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+
+  result = Test_SampleAccurateLoop(tm);
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+
+  result = Test_BoundaryStopLoop(tm);
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+
+  result = Test_GainRamps(tm);
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+
+  result = Test_TrackGainAndPan(tm);
+  if (!result) {
+    std::cout << "---> TEST FAILED" << std::endl;
+  }
+
 #endif
 
   return 0;
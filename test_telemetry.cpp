@@ -0,0 +1,146 @@
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "telemetry.h"
+
+static const char *kName = "/rpi_looper_telemetry_test";
+
+// Every field follows from n, a torn copy mixes two publishes
+static void FillData(TelemetryData &data, uint32_t n) {
+  data.timestamp_ns = n;
+  data.frame = (uint64_t)n * 128;
+  data.sample_rate = 48000;
+  data.master_current_index = n;
+  data.master_end_index = n + 1;
+  for (uint32_t t = 0; t < MAX_TRACK_COUNT; t++) {
+    data.track_state[t] = (n + t) % 6;
+  }
+  data.active_group = n % MAX_GROUP_COUNT;
+  data.last_track = n % MAX_TRACK_COUNT;
+  data.dsp_load_permille = n;
+  data.worst_load_permille = n;
+  data.xruns = n;
+  data.late_cycles = n;
+  data.command_queue_depth = n;
+  data.overrun_queue_depth = n;
+  data.pool_pages_in_use = n;
+  data.pool_page_count = n;
+  data.input_peak[0] = data.input_peak[1] = n;
+  data.output_peak[0] = data.output_peak[1] = n;
+}
+
+static bool IsConsistent(const TelemetryData &data) {
+  TelemetryData expected = {};
+  FillData(expected, data.master_current_index);
+  return memcmp(&data, &expected, sizeof(TelemetryData)) == 0;
+}
+
+// Nothing to read before the first publish, then the last publish
+bool Test_PublishAndRead(void) {
+  TelemetryWriter writer;
+  TelemetryReader reader;
+  TelemetryData data = {};
+  bool result = true;
+  if (!writer.Open(kName) || !reader.Open(kName)) {
+    std::cout << "error: can't open " << kName << std::endl;
+    return false;
+  }
+  if (reader.Read(data)) {
+    std::cout << "error: read before the first publish" << std::endl;
+    result = false;
+  }
+  for (uint32_t n = 1; n <= 3; n++) {
+    FillData(data, n);
+    writer.Publish(data);
+  }
+  data = {};
+  if (!reader.Read(data) || data.master_current_index != 3 || !IsConsistent(data)) {
+    std::cout << "error: read " << data.master_current_index << std::endl;
+    result = false;
+  }
+  if (reader.GetSequence() != 3) {
+    std::cout << "error: sequence " << reader.GetSequence() << std::endl;
+    result = false;
+  }
+  return result;
+}
+
+// A reader polling while the writer publishes flat out never gets a torn copy
+// and never goes back in time
+bool Test_NoTornReads(void) {
+  TelemetryWriter writer;
+  TelemetryReader reader;
+  if (!writer.Open(kName) || !reader.Open(kName)) {
+    std::cout << "error: can't open " << kName << std::endl;
+    return false;
+  }
+  const uint32_t kPublishes = 200000;
+  std::thread writer_thread([&writer, kPublishes]() {
+    TelemetryData data = {};
+    for (uint32_t n = 1; n <= kPublishes; n++) {
+      FillData(data, n);
+      writer.Publish(data);
+    }
+  });
+  bool result = true;
+  uint32_t reads = 0;
+  uint32_t last = 0;
+  while (last < kPublishes) {
+    TelemetryData data;
+    if (!reader.Read(data)) { continue; }
+    reads++;
+    if (!IsConsistent(data) || data.master_current_index < last) {
+      std::cout << "error: torn or stale read at " << data.master_current_index << std::endl;
+      result = false;
+      break;
+    }
+    last = data.master_current_index;
+  }
+  writer_thread.join();
+  if (reads == 0) {
+    std::cout << "error: no reads" << std::endl;
+    result = false;
+  }
+  return result;
+}
+
+// A reader built against another layout refuses the object
+bool Test_VersionMismatch(void) {
+  TelemetryWriter writer;
+  if (!writer.Open(kName)) {
+    std::cout << "error: can't open " << kName << std::endl;
+    return false;
+  }
+  writer.Close();
+  int fd = shm_open(kName, O_RDWR, 0);
+  TelemetryPage *page = (TelemetryPage*)mmap(nullptr, sizeof(TelemetryPage), PROT_READ | PROT_WRITE,
+                                             MAP_SHARED, fd, 0);
+  close(fd);
+  page->version = TELEMETRY_VERSION + 1;
+  munmap(page, sizeof(TelemetryPage));
+  TelemetryReader reader;
+  if (reader.Open(kName)) {
+    std::cout << "error: opened a version " << TELEMETRY_VERSION + 1 << " object" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  std::cout << "** test_telemetry.cpp **" << std::endl;
+  bool tests[3] = {false};
+  tests[0] = Test_PublishAndRead();
+  tests[1] = Test_NoTornReads();
+  tests[2] = Test_VersionMismatch();
+  for (auto result : tests) {
+    if (!result) {
+      std::cout << "---> TEST FAILED" << std::endl;
+    }
+    std::cout << result << std::endl;
+  }
+  shm_unlink(kName);
+  return 0;
+}
@@ -157,12 +157,49 @@ void Test_SimulateOverdub(Track &test_track) {
   test_track.SetTrackToOverdubbing();
 }
 
+// Pages are only taken from the pool when written and returned when the track is off
+void Test_PagedStorage(Track &test_track) {
+  std::cout << "** test_track.cpp: Test_PagedStorage **" << std::endl;
+  DataBlock zeros(0.0f), test_data_2p2(2.2f);
+  BlockPool &pool = BlockPool::getInstance();
+  uint32_t pages_in_use = pool.GetPagesInUse();
+  uint32_t far_block = MAX_BLOCK_COUNT - 1;
+
+  // Unwritten blocks read as silence without using a page
+  bool result = AreBlocksMatching(zeros, test_track.GetBlockData(far_block)) &&
+                pool.GetPagesInUse() == pages_in_use;
+  std::cout << "** unwritten block silent? " << result << " **" << std::endl;
+
+  test_track.SetBlockData(far_block, test_data_2p2);
+  result = AreBlocksMatching(test_data_2p2, test_track.GetBlockData(far_block)) &&
+           pool.GetPagesInUse() == pages_in_use + 1;
+  std::cout << "** written block allocated one page? " << result << " **" << std::endl;
+
+  // Neighbour on the same page comes from a zeroed page
+  result = AreBlocksMatching(zeros, test_track.GetBlockData(far_block - 1));
+  std::cout << "** neighbour block silent? " << result << " **" << std::endl;
+
+  uint32_t track_pages = test_track.GetPageCount();
+  test_track.SetTrackToOff();
+  result = test_track.GetPageCount() == 0 &&
+           pool.GetPagesInUse() == pages_in_use + 1 - track_pages &&
+           AreBlocksMatching(zeros, test_track.GetBlockData(far_block));
+  std::cout << "** off released pages? " << result << " **" << std::endl;
+
+  // Reused pages must not carry old data, the last page released is handed out first
+  test_track.SetBlockData(0, test_data_2p2);
+  result = AreBlocksMatching(zeros, test_track.GetBlockData(far_block % BLOCKS_PER_PAGE));
+  std::cout << "** reused page silent? " << result << " **" << std::endl;
+  test_track.SetTrackToOff();
+}
+
 // TODO Turn this into a test
 int main() {
   std::cout << "** test_track.cpp **" << std::endl;
   Test_SimulateRecord(test_track);
   Test_SimulatePlayback(test_track);
   Test_SimulateOverdub(test_track);
+  Test_PagedStorage(test_track);
 
   return 0;
 }
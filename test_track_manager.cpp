@@ -180,12 +180,13 @@ void Test_Overdub_SingleTrack(TrackManager &tm) {
     std::cout << "error: curr index " << tm.tracks.at(track_number).GetCurrentIndex() << " not exp val " << data_block_number << " **" << std::endl;
   }
 
-  if (data_block_number != tm.tracks.at(track_number).GetEndIndex()) {
-    std::cout << "error end index " << tm.tracks.at(track_number).GetEndIndex() << " not exp val " << data_block_number << " **" << std::endl;
+  // the end is the last block overdubbed, the current index is the one after
+  if (data_block_number - 1 != tm.tracks.at(track_number).GetEndIndex()) {
+    std::cout << "error end index " << tm.tracks.at(track_number).GetEndIndex() << " not exp val " << data_block_number - 1 << " **" << std::endl;
   }
 
-  if (data_block_number != tm.GetMasterEndIndex()) {
-    std::cout << "error master end index " << tm.GetMasterEndIndex() << " not exp val " << data_block_number << " **" << std::endl;
+  if (data_block_number - 1 != tm.GetMasterEndIndex()) {
+    std::cout << "error master end index " << tm.GetMasterEndIndex() << " not exp val " << data_block_number - 1 << " **" << std::endl;
   }
 
   std::cout << std::endl << "    Performing check on each block **" << std::endl;
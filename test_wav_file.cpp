@@ -0,0 +1,66 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+#include "wav_file.h"
+
+static const char *kPath = "/tmp/test_wav_file.wav";
+
+// Written as float, read back as the first channel unchanged
+bool Test_FloatRoundTrip(void) {
+  std::vector<float> left = {0.0f, 0.5f, -0.25f, 1.0f, -1.0f, 1.0e-7f};
+  std::vector<float> right(left.size(), 0.75f);
+  if (!WriteWav(kPath, {left, right}, 44100)) {
+    std::cout << "error: write failed" << std::endl;
+    return false;
+  }
+  std::vector<float> samples;
+  uint32_t sample_rate = 0;
+  if (!ReadWav(kPath, samples, sample_rate)) {
+    std::cout << "error: read failed" << std::endl;
+    return false;
+  }
+  if (sample_rate != 44100 || samples != left) {
+    std::cout << "error: read " << samples.size() << " samples at " << sample_rate << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// 16 bit PCM mono with a LIST chunk ahead of the data
+bool Test_ReadPcm16(void) {
+  const unsigned char wav[] = {
+    'R', 'I', 'F', 'F', 54, 0, 0, 0, 'W', 'A', 'V', 'E',
+    'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0, 0x80, 0xBB, 0, 0, 0, 0x77, 1, 0, 2, 0, 16, 0,
+    'L', 'I', 'S', 'T', 2, 0, 0, 0, 0, 0,
+    'd', 'a', 't', 'a', 6, 0, 0, 0, 0x00, 0x40, 0x00, 0xC0, 0xFF, 0x7F
+  };
+  std::ofstream(kPath, std::ios::binary).write((const char*)wav, sizeof(wav));
+  std::vector<float> samples;
+  uint32_t sample_rate = 0;
+  if (!ReadWav(kPath, samples, sample_rate)) {
+    std::cout << "error: read failed" << std::endl;
+    return false;
+  }
+  std::vector<float> expected = {0.5f, -0.5f, 32767.0f / 32768.0f};
+  if (sample_rate != 48000 || samples != expected) {
+    std::cout << "error: read " << samples.size() << " samples at " << sample_rate << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  std::cout << "** test_wav_file.cpp **" << std::endl;
+  bool tests[2] = {false};
+  tests[0] = Test_FloatRoundTrip();
+  tests[1] = Test_ReadPcm16();
+  for (auto result : tests) {
+    if (!result) {
+      std::cout << "---> TEST FAILED" << std::endl;
+    }
+    std::cout << result << std::endl;
+  }
+  remove(kPath);
+  return 0;
+}
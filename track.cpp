@@ -1,12 +1,17 @@
 #include "track.h"
 
+uint32_t Track::state_generation_ = 0;
+DataBlock Track::discard_block_;
+
 void Track::SetTrackMembersToDefault() {
   start_index_ = 0;
   end_index_ = 0;
   current_index_ = 0;
+  end_offset_ = 0;
   current_state_ = TrackState::kOff;
   previous_state_ = TrackState::kOff; // only used when muting/unmuting
   is_track_silent_ = true;
+  state_generation_++;
 }
 
 void Track::RestoreUsingSetState() {
@@ -36,26 +41,59 @@ void Track::RestoreUsingSetState() {
 Track::Track():Track(0.0f) {
 }
 
-Track::Track(float init_val) {
-  DataBlock temp(init_val);
-  for (auto& fb : frame_blocks) {
-    fb.samples_ = temp.samples_;
-  }
+// Pages are allocated on first write, unless a non zero value is requested
+// in which case every block must hold it
+Track::Track(float init_val) : pool_(&BlockPool::getInstance()) {
+  pages_.fill(nullptr);
   SetTrackMembersToDefault();
+  if (init_val != 0.0f) {
+    for (uint32_t block = 0; block < MAX_BLOCK_COUNT; block++) {
+      SetBlockDataToSameValue(block, init_val);
+    }
+  }
+}
+
+Track::~Track() {
+  ReleasePages();
+}
+
+void Track::ReleasePages() {
+  for (auto& page : pages_) {
+    if (page != nullptr) {
+      pool_->Release(page);
+      page = nullptr;
+    }
+  }
 }
 
 void Track::SetBlockDataToSameValue(uint32_t block_number, float value) {
-  frame_blocks.at(block_number).samples_.fill(value);
+  GetBlockDataForWrite(block_number).samples_.fill(value);
 }
 
 // Called by Record, TrackManager will send master current index
 // to write the data to the correct block
 void Track::SetBlockData(uint32_t block_number, DataBlock &block) {
-  frame_blocks.at(block_number).samples_ = block.samples_;
+  GetBlockDataForWrite(block_number).samples_ = block.samples_;
 }
 
 const DataBlock & Track::GetBlockData(uint32_t block_number) {
-  return frame_blocks.at(block_number);
+  DataBlock *page = pages_.at(block_number / BLOCKS_PER_PAGE);
+  if (page == nullptr) {
+    return pool_->GetZeroBlock();
+  }
+  return page[block_number % BLOCKS_PER_PAGE];
+}
+
+DataBlock & Track::GetBlockDataForWrite(uint32_t block_number) {
+  DataBlock *&page = pages_.at(block_number / BLOCKS_PER_PAGE);
+  if (page == nullptr) {
+    page = pool_->Allocate();
+    // Out of pages, the recording is lost but the audio thread carries on
+    if (page == nullptr) {
+      return discard_block_;
+    }
+  }
+  return page[block_number % BLOCKS_PER_PAGE];
 }
 
 void Track::SetStartIndex(uint32_t start) {
@@ -82,6 +120,14 @@ uint32_t Track::GetEndIndex() {
   return end_index_;
 }
 
+void Track::SetEndOffset(uint32_t offset) {
+  end_offset_ = offset;
+}
+
+uint32_t Track::GetEndOffset() {
+  return end_offset_;
+}
+
 uint32_t Track::GetCurrentIndex() {
   return current_index_;
 }
@@ -98,6 +144,10 @@ void Track::SetTrackSilent(bool set_silent) {
   is_track_silent_ = set_silent;
 }
 
+TrackState Track::GetTrackState() {
+  return current_state_;
+}
+
 bool Track::IsTrackOff() {
   return current_state_ == TrackState::kOff;
 }
@@ -124,18 +174,21 @@ bool Track::IsTrackMuted() {
 
 void Track::SetTrackToOff() {
   SetTrackMembersToDefault();
+  ReleasePages();
 }
 
 void Track::SetTrackToOverdubbing() {
   SetTrackSilent(false);
   current_state_ = TrackState::kOverdub;
   previous_state_ = current_state_;
+  state_generation_++;
 }
 
 void Track::SetTrackToInPlayback() {
   SetTrackSilent(false);
   current_state_ = TrackState::kPlayback;
   previous_state_ = current_state_;
+  state_generation_++;
 }
 
 void Track::SetTrackToInPlaybackRepeat() {
@@ -143,12 +196,14 @@ void Track::SetTrackToInPlaybackRepeat() {
   SetTrackSilent(false);
   current_state_ = TrackState::kRepeat;
   previous_state_ = current_state_;
+  state_generation_++;
 }
 
 void Track::SetTrackToInRecord() {
   SetTrackSilent(false);
   current_state_ = TrackState::kRecord;
   previous_state_ = current_state_;
+  state_generation_++;
 }
 
 void Track::SaveCurrentState() {
@@ -163,4 +218,17 @@ void Track::RestoreCurrentState() {
 void Track::SetTrackToMuted() {
   SetTrackSilent(true);
   current_state_ = TrackState::kMuted;
+  state_generation_++;
+}
+
+uint32_t Track::GetStateGeneration() {
+  return state_generation_;
+}
+
+uint32_t Track::GetPageCount() {
+  uint32_t count = 0;
+  for (const auto& page : pages_) {
+    if (page != nullptr) { count++; }
+  }
+  return count;
 }
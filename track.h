@@ -6,6 +6,7 @@
 #include <iterator>
 
 #include "data_block.h"
+#include "block_pool.h"
 
 enum class TrackState {
   kOff = 0,   // Empty track or available for recording
@@ -29,21 +30,40 @@ class Track {
   uint32_t start_index_;
   uint32_t end_index_;
   uint32_t current_index_;
+  // Samples recorded into the end block, 0 for the whole block
+  uint32_t end_offset_;
   bool is_track_silent_;
   TrackState current_state_;
   TrackState previous_state_;
-  std::array<DataBlock, MAX_BLOCK_COUNT> frame_blocks;
+  // Page table, pages are taken from the BlockPool the first time one of their
+  // blocks is written and given back when the track is set to off. Blocks on a
+  // page that isn't allocated read as silence
+  std::array<DataBlock*, PAGES_PER_TRACK> pages_;
+  BlockPool *pool_;
+  // Written to when the pool has run out of pages, never read
+  static DataBlock discard_block_;
+  // Bumped on every state change of any track, lets the mixer know when
+  // its list of audible tracks is stale
+  static uint32_t state_generation_;
 
   void SetTrackMembersToDefault();
   void RestoreUsingSetState();
+  void ReleasePages();
+
+  // Pages are owned by a single track
+  Track(const Track& other);
+  Track& operator=(const Track& other);
 
   public:
   // Member Functions
   Track();
   Track(float init_val);
+  ~Track();
   void SetBlockDataToSameValue(uint32_t block_number, float value);
   void SetBlockData(uint32_t block_number, DataBlock &block);
   const DataBlock & GetBlockData(uint32_t block_number);
+  // Direct write access for record and overdub, avoids a temporary block
+  DataBlock & GetBlockDataForWrite(uint32_t block_number);
 
   void SetStartIndex(uint32_t start);
   void SetEndIndex(uint32_t end);
@@ -53,6 +73,8 @@ class Track {
   uint32_t GetStartIndex();
   uint32_t GetEndIndex();
   uint32_t GetCurrentIndex();
+  void SetEndOffset(uint32_t offset);
+  uint32_t GetEndOffset();
 
   // Handles Off or Muted or Playback when master_current_index outside track's start_index
   // and end_index range
@@ -65,6 +87,7 @@ class Track {
   bool IsTrackInPlaybackRepeat();
   bool IsTrackInRecord();
   bool IsTrackMuted();
+  TrackState GetTrackState();
 
   void SetTrackToOff();
   void SetTrackToOverdubbing();
@@ -74,5 +97,8 @@ class Track {
   void SaveCurrentState();
   void RestoreCurrentState();
   void SetTrackToMuted();
+  static uint32_t GetStateGeneration();
+  // Number of pages currently held by this track
+  uint32_t GetPageCount();
 };
 #endif // TRACK_H
@@ -1,13 +1,38 @@
+#include <algorithm>
 #include <thread>
 #include "track_manager.h"
 #include "track_manager_states.h"
-
-static DataBlock empty_block;
+#include "rt_log.h"
 
 // Default Constructor - set all data to zero
 TrackManager::TrackManager() {
+  // Pick the mix kernel before any audio is processed
+  MixerInit();
   current_state = &Off::getInstance();
   active_group_tracks_ = 0xFFFF;
+  active_track_count_ = 0;
+  active_tracks_generation_ = Track::GetStateGeneration() - 1; // force first update
+  io_input_ = nullptr;
+  io_output_ = nullptr;
+  mixdown_performed_ = false;
+  block_offset_ = 0;
+  block_end_ = SAMPLES_PER_BLOCK;
+  master_end_offset_ = 0;
+  segment_offset_ = 0;
+  segment_length_ = SAMPLES_PER_BLOCK;
+  last_track_number_ = 0;
+  quantize_subdivisions_ = 0;
+  quantize_count_ = 0;
+  quantize_dropped_ = 0;
+  ramp_samples_ = GAIN_RAMP_DEFAULT_SAMPLES;
+  audible_tracks_ = 0;
+  muted_tracks_ = 0;
+  fading_in_tracks_ = 0;
+  tail_tracks_ = 0;
+  position_jumped_ = false;
+  jump_position_ = 0;
+  seam_fade_samples_ = 0;
+  SetMixParameters(nullptr);
 }
 
 // Handle Index
@@ -32,52 +57,259 @@ void TrackManager::SilentPlaybackTrack(uint32_t track, uint32_t index) {
   }
 }
 
+// Off and muted tracks never reach the mixer, tracks in playback are checked
+// each block as they are silent outside of their start and end indexes
+void TrackManager::UpdateActiveTrackList() {
+  active_track_count_ = 0;
+  uint16_t audible = 0;
+  uint16_t muted = 0;
+  for (uint32_t t = 0; t < tracks.size(); t++) {
+    if (tracks.at(t).IsTrackMuted()) {
+      muted |= 0x1 << t;
+    }
+    if (tracks.at(t).IsTrackOff() || tracks.at(t).IsTrackMuted()) {
+      continue;
+    }
+    active_tracks_[active_track_count_++] = t;
+    audible |= 0x1 << t;
+  }
+  active_tracks_generation_ = Track::GetStateGeneration();
+  if (ramp_samples_ != 0) {
+    StartGainRamps(audible, muted);
+  }
+  audible_tracks_ = audible;
+  muted_tracks_ = muted;
+  position_jumped_ = false;
+}
+
+// Tracks muted fade out from their tail and tracks unmuted fade in. Across a
+// jump tracks heard on both sides crossfade. Recording doesn't fade in, that
+// would fade the input being monitored
+void TrackManager::StartGainRamps(uint16_t audible, uint16_t muted) {
+  for (uint32_t t = 0; t < tracks.size(); t++) {
+    uint16_t bit = 0x1 << t;
+    if (tracks.at(t).IsTrackOff()) {
+      // pages are gone, nothing left to fade
+      fading_in_tracks_ &= ~bit;
+      tail_tracks_ &= ~bit;
+      continue;
+    }
+    bool was_audible = audible_tracks_ & bit;
+    bool is_audible = audible & bit;
+    bool follows_master = !tracks.at(t).IsTrackInPlaybackRepeat();
+    bool recording = tracks.at(t).IsTrackInRecord() || tracks.at(t).IsTrackOverdubbing();
+    bool jumped = position_jumped_ && follows_master && !recording;
+    if (was_audible && ((muted & bit) || (is_audible && jumped))) {
+      // a fade in that hadn't finished fades out from the gain it reached
+      tail_done_[t] = (fading_in_tracks_ & bit) ? ramp_samples_ - fade_in_done_[t] : 0;
+      tail_position_[t] = jumped ? jump_position_ :
+                          DetermineIndex(t) * SAMPLES_PER_BLOCK + block_offset_;
+      tail_tracks_ |= bit;
+      fading_in_tracks_ &= ~bit;
+    }
+    if (is_audible && ((muted_tracks_ & bit) || (was_audible && jumped)) && !recording) {
+      fade_in_done_[t] = 0;
+      fading_in_tracks_ |= bit;
+    }
+  }
+}
+
+// Tracks fading in, the rest of the segment after the ramp is at full gain
+void TrackManager::MixGainRamps(float *output, uint32_t ramp_count) {
+  float step = 1.0f / ramp_samples_;
+  for (uint32_t r = 0; r < ramp_count; r++) {
+    uint32_t t = ramp_tracks_[r];
+    const float *source = ramp_sources_[r];
+    float gain = track_gain_[t];
+    uint32_t done = fade_in_done_[t];
+    uint32_t length = std::min(segment_length_, ramp_samples_ - done);
+    MixSourceRamp(source, output, done * step * gain, step * gain, length);
+    if (length < segment_length_) {
+      MixSourceRamp(source + length, output + length, gain, 0.0f, segment_length_ - length);
+    }
+    fade_in_done_[t] = done + length;
+    if (fade_in_done_[t] == ramp_samples_) {
+      fading_in_tracks_ &= ~(0x1 << t);
+    }
+  }
+}
+
+// Ramps from the gain reached so far, a change during a change starts over
+void TrackManager::StartGainChange(uint32_t track, float target) {
+  gain_target_[track] = target;
+  if (ramp_samples_ == 0) {
+    track_gain_[track] = target;
+    return;
+  }
+  gain_start_[track] = track_gain_[track];
+  gain_step_[track] = (target - track_gain_[track]) / ramp_samples_;
+  gain_change_done_[track] = 0;
+  gain_changing_tracks_ |= 0x1 << track;
+}
+
+// Tracks changing gain, the rest of the segment after the change is at the target
+void TrackManager::MixGainChanges(float *output, uint32_t change_count) {
+  for (uint32_t c = 0; c < change_count; c++) {
+    uint32_t t = change_tracks_[c];
+    const float *source = change_sources_[c];
+    uint32_t done = gain_change_done_[t];
+    uint32_t length = std::min(segment_length_, ramp_samples_ - done);
+    MixSourceRamp(source, output, gain_start_[t] + done * gain_step_[t], gain_step_[t], length);
+    if (length < segment_length_) {
+      MixSourceRamp(source + length, output + length, gain_target_[t], 0.0f, segment_length_ - length);
+    }
+    gain_change_done_[t] = done + length;
+    track_gain_[t] = gain_start_[t] + gain_change_done_[t] * gain_step_[t];
+    if (gain_change_done_[t] == ramp_samples_) {
+      track_gain_[t] = gain_target_[t];
+      gain_changing_tracks_ &= ~(0x1 << t);
+    }
+  }
+}
+
+// Tails are read from their own position, which may cross a block boundary
+// or the loop end within the segment. While the focus track records or
+// overdubs the loop end isn't known yet, they wrap where the master index does
+void TrackManager::MixTails(float *output) {
+  float step = 1.0f / ramp_samples_;
+  uint32_t loop_end = MAX_BLOCK_COUNT * SAMPLES_PER_BLOCK;
+  if (!tracks.at(last_track_number_).IsTrackInRecord() &&
+      !tracks.at(last_track_number_).IsTrackOverdubbing()) {
+    loop_end = master_end_index_ * SAMPLES_PER_BLOCK +
+               (master_end_offset_ != 0 ? master_end_offset_ : SAMPLES_PER_BLOCK);
+  }
+  for (uint32_t t = 0; t < tracks.size(); t++) {
+    uint16_t bit = 0x1 << t;
+    if (!(tail_tracks_ & bit)) {
+      continue;
+    }
+    float gain = track_gain_[t];
+    uint32_t length = std::min(segment_length_, ramp_samples_ - tail_done_[t]);
+    uint32_t done = 0;
+    while (done < length) {
+      if (tail_position_[t] >= loop_end) {
+        tail_position_[t] = 0;
+      }
+      uint32_t index = tail_position_[t] / SAMPLES_PER_BLOCK;
+      uint32_t offset = tail_position_[t] % SAMPLES_PER_BLOCK;
+      uint32_t chunk = std::min(std::min(length - done, SAMPLES_PER_BLOCK - offset),
+                                loop_end - tail_position_[t]);
+      const float *source = tracks.at(t).GetBlockData(index).samples_.data() + offset;
+      MixSourceRamp(source, output + done, (1.0f - (tail_done_[t] + done) * step) * gain,
+                    -step * gain, chunk);
+      tail_position_[t] += chunk;
+      done += chunk;
+    }
+    tail_done_[t] = std::min(ramp_samples_, tail_done_[t] + length);
+    if (tail_done_[t] == ramp_samples_) {
+      tail_tracks_ &= ~bit;
+    }
+  }
+}
+
+// Fade out over the last samples of the loop and in over the first. Not while
+// the focus track records or overdubs, the loop end isn't known yet
+void TrackManager::ApplySeamFade(float *output) {
+  if (master_end_index_ == 0 || tracks.at(last_track_number_).IsTrackInRecord() ||
+      tracks.at(last_track_number_).IsTrackOverdubbing()) {
+    return;
+  }
+  float step = 1.0f / seam_fade_samples_;
+  uint32_t segment_end = segment_offset_ + segment_length_;
+  if (master_current_index_ == 0 && segment_offset_ < seam_fade_samples_) {
+    uint32_t end = std::min(segment_end, seam_fade_samples_);
+    ApplyGainRamp(output, segment_offset_ * step, step, end - segment_offset_);
+  }
+  if (master_current_index_ == master_end_index_) {
+    uint32_t loop_end = master_end_offset_ != 0 ? master_end_offset_ : SAMPLES_PER_BLOCK;
+    uint32_t fade_start = loop_end > seam_fade_samples_ ? loop_end - seam_fade_samples_ : 0;
+    uint32_t start = std::max(segment_offset_, fade_start);
+    uint32_t end = std::min(segment_end, loop_end);
+    if (start < end) {
+      ApplyGainRamp(output + (start - segment_offset_), (loop_end - start) * step, -step, end - start);
+    }
+  }
+}
+
 // Perform Mixdown
-// Pass empty_block in place of tracks off/muted/in other group
+// Single pass over the mixdown with only the audible tracks, tracks fading in
+// or out are added after. The plain sum is used while every gain is at unity
 void TrackManager::PerformMixdown() {
-  uint32_t index_one = 0;
-  uint32_t index_two = 0;
-  // Clear mixdown as MixBlocks does not do this and shouldn't for simplicity
-  mixdown.SetData(empty_block);
-
-  for (uint32_t t = 0; t < tracks.size(); t+=2) {
-    // Handle index
-    index_one = DetermineIndex(t);
-    index_two = DetermineIndex(t + 1);
+  if (active_tracks_generation_ != Track::GetStateGeneration() || position_jumped_) {
+    UpdateActiveTrackList();
+  }
 
+  uint32_t source_count = 0;
+  uint32_t ramp_count = 0;
+  uint32_t change_count = 0;
+  bool unity = true;
+  for (uint32_t a = 0; a < active_track_count_; a++) {
+    uint32_t t = active_tracks_[a];
+    uint32_t index = DetermineIndex(t);
     // tracks in playback when master_current_index_ is outside range
     // need to be set to silent
-    SilentPlaybackTrack(t, index_one);
-    SilentPlaybackTrack(t + 1, index_two);
-
-    // Handle block mixdown based upon state
-    // TODO - non-active group needs to be in here too
-    if (tracks.at(t).IsTrackSilent() && tracks.at(t + 1).IsTrackSilent()) {
-      MixBlocks(empty_block,
-                empty_block,
-                mixdown);
-    } else if (tracks.at(t).IsTrackSilent() && !tracks.at(t + 1).IsTrackSilent()) {
-      MixBlocks(empty_block,
-                tracks.at(t + 1).GetBlockData(index_two),
-                mixdown);
-    } else if (!tracks.at(t).IsTrackSilent() && tracks.at(t + 1).IsTrackSilent()) {
-      MixBlocks(tracks.at(t).GetBlockData(index_one),
-                empty_block,
-                mixdown);
-    } else {
-      MixBlocks(tracks.at(t).GetBlockData(index_one),
-                tracks.at(t + 1).GetBlockData(index_two),
-                mixdown);
+    SilentPlaybackTrack(t, index);
+    if (!tracks.at(t).IsTrackSilent()) {
+      const float *source = tracks.at(t).GetBlockData(index).samples_.data() + segment_offset_;
+      float target = 1.0f;
+      if (mix_parameters_ != nullptr) {
+        target = mix_parameters_->GetChannelGain(mix_channel_, t);
+      }
+      uint16_t bit = 0x1 << t;
+      if (fading_in_tracks_ & bit) {
+        // the fade in covers the jump to the target
+        track_gain_[t] = gain_target_[t] = target;
+        gain_changing_tracks_ &= ~bit;
+        ramp_sources_[ramp_count] = source;
+        ramp_tracks_[ramp_count++] = t;
+        continue;
+      }
+      if (target != gain_target_[t]) {
+        StartGainChange(t, target);
+      }
+      if (gain_changing_tracks_ & bit) {
+        change_sources_[change_count] = source;
+        change_tracks_[change_count++] = t;
+      } else {
+        unity &= track_gain_[t] == 1.0f;
+        mix_gains_[source_count] = track_gain_[t];
+        mix_sources_[source_count++] = source;
+      }
     }
   }
+  // MixSources overwrites the mixdown, no need to clear it first
+  float *output = io_output_ != nullptr ? io_output_ : mixdown.samples_.data() + segment_offset_;
+  if (unity) {
+    MixSources(mix_sources_.data(), source_count, output, segment_length_);
+  } else {
+    MixSourcesGain(mix_sources_.data(), mix_gains_.data(), source_count, output, segment_length_);
+  }
+  if (change_count != 0) {
+    MixGainChanges(output, change_count);
+  }
+  if (ramp_count != 0) {
+    MixGainRamps(output, ramp_count);
+  }
+  if (tail_tracks_ != 0) {
+    MixTails(output);
+  }
+  if (seam_fade_samples_ != 0) {
+    ApplySeamFade(output);
+  }
+  mixdown_performed_ = true;
 }
 
 /*
  * Index Handlers
  */
 
-void TrackManager::SetMasterCurrentIndex(uint32_t current) {
+void TrackManager::SetMasterCurrentIndex(uint32_t current, bool crossfade) {
+  if (crossfade && ramp_samples_ != 0 && !position_jumped_) {
+    jump_position_ = master_current_index_ * SAMPLES_PER_BLOCK + block_offset_;
+    position_jumped_ = true;
+  }
   master_current_index_ = current;
+  block_offset_ = 0;
 }
 void TrackManager::SetMasterEndIndex(uint32_t end) {
   master_end_index_ = end;
@@ -88,6 +320,29 @@ uint32_t TrackManager::GetMasterCurrentIndex() {
 uint32_t TrackManager::GetMasterEndIndex() {
   return master_end_index_;
 }
+void TrackManager::SetMasterEndOffset(uint32_t offset) {
+  master_end_offset_ = offset;
+}
+uint32_t TrackManager::GetMasterEndOffset() {
+  return master_end_offset_;
+}
+uint32_t TrackManager::GetMasterCurrentOffset() {
+  return block_offset_;
+}
+
+// The loop wraps part way into its last block when recording stopped mid-block.
+// Not while the focus track records or overdubs as that may extend the loop
+uint32_t TrackManager::MasterBlockEnd() {
+  if (master_end_offset_ == 0 || master_current_index_ != master_end_index_ ||
+      block_offset_ >= master_end_offset_) {
+    return SAMPLES_PER_BLOCK;
+  }
+  if (tracks.at(last_track_number_).IsTrackInRecord() ||
+      tracks.at(last_track_number_).IsTrackOverdubbing()) {
+    return SAMPLES_PER_BLOCK;
+  }
+  return master_end_offset_;
+}
 
 // If master_current_index_ reaches max available space, reset it and change state if
 // required
@@ -128,6 +383,7 @@ void TrackManager::IndexUpdatePlaybackEnter(uint32_t track_number) {
   // If entering play and MCI == MEI, set MCI to 0, IE restart from beginning
   if (master_current_index_ >= master_end_index_) {
     master_current_index_ = 0;
+    block_offset_ = 0;
   }
   tracks.at(track_number).SetCurrentIndex(master_current_index_);
 }
@@ -139,6 +395,7 @@ void TrackManager::IndexUpdateRepeatEnter(uint32_t track_number) {
   // If entering repeat and MCI == MEI, set MCI to 0, IE restart from beginning
   if (master_current_index_ >= master_end_index_) {
     master_current_index_ = 0;
+    block_offset_ = 0;
   }
   tracks.at(track_number).SetCurrentIndex(tracks.at(track_number).GetStartIndex());
 }
@@ -243,14 +500,32 @@ void TrackManager::IndexUpdateRepeatNoChange(uint32_t track_number) {
  * Index Handlers Exit State - when changing to another state
  */
 
+// The last block written and how far into it, offset 0 is the whole block.
+// Stopped on a block boundary nothing has been written to the current block
+// yet, so the end is the whole of the block before it
+void TrackManager::LastWrittenPosition(uint32_t start_index, uint32_t &index, uint32_t &offset) {
+  index = master_current_index_;
+  offset = block_offset_;
+  if (offset == 0 && index > start_index) {
+    index--;
+  }
+}
+
 // OnExitState (leaving to another state)
 // -> Set EndIndex to CurrentIndex
 // -> If CurrentIndex > MasterEndIndex, Set MasterEndIndex to CurrentIndex
+// Stopped part way into a block, the loop ends at that sample
 void TrackManager::IndexUpdateRecordExit(uint32_t track_number) {
-  uint32_t current_index = master_current_index_;
-  tracks.at(track_number).SetEndIndex(current_index);
-  if (current_index > master_end_index_) {
-    master_end_index_ = current_index;
+  uint32_t end_index, end_offset;
+  LastWrittenPosition(tracks.at(track_number).GetStartIndex(), end_index, end_offset);
+  tracks.at(track_number).SetEndIndex(end_index);
+  tracks.at(track_number).SetEndOffset(end_offset);
+  if (end_index > master_end_index_) {
+    master_end_index_ = end_index;
+    master_end_offset_ = end_offset;
+  } else if (end_index == master_end_index_ && master_end_offset_ != 0 &&
+             (end_offset == 0 || end_offset > master_end_offset_)) {
+    master_end_offset_ = end_offset;
   }
 }
 
@@ -258,12 +533,15 @@ void TrackManager::IndexUpdateRecordExit(uint32_t track_number) {
 // -> If CurrentIndex > EndIndex, Set EndIndex to CurrentIndex
 // -> If CurrentIndex > MasterEndIndex, Set MasterEndIndex to CurrentIndex
 void TrackManager::IndexUpdateOverdubExit(uint32_t track_number) {
-  uint32_t current_index = master_current_index_;
-  if (current_index > tracks.at(track_number).GetEndIndex()) {
-    tracks.at(track_number).SetEndIndex(current_index);
+  uint32_t end_index, end_offset;
+  LastWrittenPosition(0, end_index, end_offset);
+  if (end_index > tracks.at(track_number).GetEndIndex()) {
+    tracks.at(track_number).SetEndIndex(end_index);
+    tracks.at(track_number).SetEndOffset(end_offset);
   }
-  if (current_index > master_end_index_) {
-    master_end_index_ = current_index;
+  if (end_index > master_end_index_) {
+    master_end_index_ = end_index;
+    master_end_offset_ = end_offset;
   }
 }
 
@@ -285,6 +563,10 @@ void TrackManager::IndexUpdateRepeatExit(uint32_t track_number) {
 // Unless all tracks are in off, update master here
 // A flag exists because we should update the master current index only once
 void TrackManager::IndexUpdateAllStatesNoChange() {
+  // Partial block - indexes move on once the rest of the block is processed
+  if (segment_offset_ + segment_length_ < block_end_) {
+    return;
+  }
   // loop through all tracks
   master_current_index_updated_ = false;
   for (uint32_t track_number = 0; track_number < tracks.size(); track_number++) {
@@ -414,8 +696,8 @@ void TrackManager::HandleStateChange_Overdubbing(uint32_t track_number, DataBloc
   MixBlocks(tracks.at(track_number).GetBlockData(current_index), data, temp_block);
   // -> track.SetBlockData(CurrentBlockIndex, temp_block)
 #ifdef DTEST_TM_VERBOSE
-std::cout << "  *** SetBlockData Overdub curr_idx " << current_index << std::endl;
-std::cout << "      master_current_index_ " << master_current_index_ << std::endl;
+RT_LOG("  *** SetBlockData Overdub curr_idx %u", current_index);
+RT_LOG("      master_current_index_ %u", master_current_index_);
 temp_block.PrintBlock();
 #endif
 
@@ -492,7 +774,7 @@ void TrackManager::HandleMuteUnmuteTracks(uint16_t tracks_to_mute_unmute) {
         if (tracks.at(track_number).IsTrackInRecord()) {
           // do proper state change - rec to play just like rec on diff track while rec on orig track
 	  // simulate a down event which will transition from record to playback
-	  HandleDownEvent(track_number);
+	  ApplyTrackEvent(TrackEvent::kDown, track_number);
 	}
         tracks.at(track_number).SaveCurrentState();
       }
@@ -556,18 +838,19 @@ void TrackManager::SetState(TrackManagerState &new_state, uint32_t track_number)
  */
 
 void TrackManager::CopyBufferToTrack(uint32_t track_number) {
+  const float *input = io_input_ != nullptr ? io_input_ : input_buffer_.samples_.data() + segment_offset_;
   // record - overwrite data
   if (tracks.at(track_number).IsTrackInRecord()) {
-  tracks.at(track_number).SetBlockData(tracks.at(track_number).GetCurrentIndex(), input_buffer_);
+    DataBlock &block = tracks.at(track_number).GetBlockDataForWrite(tracks.at(track_number).GetCurrentIndex());
+    std::copy(input, input + segment_length_, begin(block.samples_) + segment_offset_);
   }
   if (tracks.at(track_number).IsTrackOverdubbing()) {
-  // overdub - mix
-    DataBlock overdub(0);
-    MixBlocks(tracks.at(track_number).GetBlockData(tracks.at(track_number).GetCurrentIndex()),
-              input_buffer_,
-	      overdub);
-    tracks.at(track_number).SetBlockData(tracks.at(track_number).GetCurrentIndex(), overdub);
-  }    
+  // overdub - mix in place
+    DataBlock &block = tracks.at(track_number).GetBlockDataForWrite(tracks.at(track_number).GetCurrentIndex());
+    float *samples = block.samples_.data() + segment_offset_;
+    const float *sources[] = {samples, input};
+    MixSources(sources, 2, samples, segment_length_);
+  }
 }
 
 void TrackManager::CopyToInputBuffer(void *d, uint32_t nsamples) {
@@ -604,55 +887,224 @@ void TrackManager::CopyMixdownToBuffer(void *d, uint32_t nsamples) {
 // Sync state machine with T1 (ie: Off) pass Down Event to T1
 // If not special case ie: REC/OVD, then still resync SM to new track
 
-void TrackManager::HandleDownEvent(uint32_t track_number) {
+void TrackManager::ApplyTrackEvent(TrackEvent event, uint32_t track_number) {
+  if (event == TrackEvent::kDown) {
+RT_LOG("TM:HDE ltn:%u, t:%u", last_track_number_, track_number);
+  }
   // sync with track
-std::cout << "TM:HDE ltn:" << last_track_number_ << ", t:" << track_number << std::endl;
   SyncTrackManagerStateWithTrackState(track_number);
-  current_state->DownEvent(*this, track_number);
+  switch (event) {
+    case TrackEvent::kDown:
+      current_state->DownEvent(*this, track_number);
+      break;
+    case TrackEvent::kDoubleDown:
+      current_state->DoubleDownEvent(*this, track_number);
+      break;
+    case TrackEvent::kShortPulse:
+      current_state->ShortPulseEvent(*this, track_number);
+      break;
+    case TrackEvent::kLongPulse:
+      current_state->LongPulseEvent(*this, track_number);
+      break;
+  }
   last_track_number_ = track_number;
 }
 
+// Held back only once a loop exists, the first recording sets its length.
+// False if the caller should apply the event now. With the queue full the
+// event is dropped, applying it would put it off the boundary and ahead of
+// the events already queued
+bool TrackManager::QueueTrackEvent(TrackEvent event, uint32_t track_number) {
+  if (quantize_subdivisions_ == 0 || master_end_index_ == 0) {
+    return false;
+  }
+  if (quantize_count_ == QUANTIZE_QUEUE_SIZE) {
+    quantize_dropped_++;
+    RT_LOG("TM:QTE: queue full, T:%u event dropped", track_number);
+    return true;
+  }
+  quantize_queue_[quantize_count_].event = event;
+  quantize_queue_[quantize_count_].track = track_number;
+  quantize_count_++;
+  return true;
+}
+
+// Called at the start of a block, master_current_index_ is the block about to play
+bool TrackManager::IsAtQuantizeBoundary() {
+  if (master_current_index_ == 0 || master_end_index_ == 0) {
+    return true;
+  }
+  uint32_t step = (master_end_index_ + 1) / quantize_subdivisions_;
+  return step == 0 || master_current_index_ % step == 0;
+}
+
+// Tracks that left the active group since the event was queued are skipped
+void TrackManager::ApplyQuantizedEvents() {
+  RT_LOG("TM:AQE: %u events at MCI %u", quantize_count_, master_current_index_);
+  for (uint32_t e = 0; e < quantize_count_; e++) {
+    uint32_t track_number = quantize_queue_[e].track;
+    if (!(active_group_tracks_ & (0x1 << track_number))) {
+      continue;
+    }
+    ApplyTrackEvent(quantize_queue_[e].event, track_number);
+  }
+  quantize_count_ = 0;
+}
+
+void TrackManager::HandleDownEvent(uint32_t track_number) {
+  if (!QueueTrackEvent(TrackEvent::kDown, track_number)) {
+    ApplyTrackEvent(TrackEvent::kDown, track_number);
+  }
+}
+
 void TrackManager::HandleDoubleDownEvent(uint32_t track_number) {
-  // sync with track
-  SyncTrackManagerStateWithTrackState(track_number);
-  current_state->DoubleDownEvent(*this, track_number);
-  last_track_number_ = track_number;
+  if (!QueueTrackEvent(TrackEvent::kDoubleDown, track_number)) {
+    ApplyTrackEvent(TrackEvent::kDoubleDown, track_number);
+  }
 }
 
 void TrackManager::HandleShortPulseEvent(uint32_t track_number) {
-  // sync with track
-  SyncTrackManagerStateWithTrackState(track_number);
-  current_state->ShortPulseEvent(*this, track_number);
-  last_track_number_ = track_number;
+  if (!QueueTrackEvent(TrackEvent::kShortPulse, track_number)) {
+    ApplyTrackEvent(TrackEvent::kShortPulse, track_number);
+  }
 }
 
 void TrackManager::HandleLongPulseEvent(uint32_t track_number) {
-  // sync with track
-  SyncTrackManagerStateWithTrackState(track_number);
-  current_state->LongPulseEvent(*this, track_number);
-  last_track_number_ = track_number;
+  if (!QueueTrackEvent(TrackEvent::kLongPulse, track_number)) {
+    ApplyTrackEvent(TrackEvent::kLongPulse, track_number);
+  }
+}
+
+void TrackManager::SetQuantize(uint32_t subdivisions) {
+  quantize_subdivisions_ = subdivisions;
+  if (subdivisions == 0 && quantize_count_ != 0) {
+    ApplyQuantizedEvents();
+  }
+}
+
+uint32_t TrackManager::GetQuantizedEventCount() {
+  return quantize_count_;
+}
+
+uint32_t TrackManager::GetDroppedQuantizedEvents() {
+  return quantize_dropped_;
+}
+
+// Fades in progress are dropped, their position is in samples of the old length
+void TrackManager::SetGainRampLength(uint32_t samples) {
+  ramp_samples_ = samples;
+  fading_in_tracks_ = 0;
+  tail_tracks_ = 0;
+  position_jumped_ = false;
+  track_gain_ = gain_target_;
+  gain_changing_tracks_ = 0;
+}
+
+void TrackManager::SetLoopSeamFade(uint32_t samples) {
+  seam_fade_samples_ = std::min<uint32_t>(samples, SAMPLES_PER_BLOCK);
+}
+
+uint16_t TrackManager::GetFadingTracks() {
+  return fading_in_tracks_ | tail_tracks_;
+}
+
+void TrackManager::SetMixParameters(MixParameters *parameters, MixChannel channel) {
+  mix_parameters_ = parameters;
+  mix_channel_ = channel;
+  for (uint32_t t = 0; t < MAX_TRACK_COUNT; t++) {
+    track_gain_[t] = parameters != nullptr ? parameters->GetChannelGain(channel, t) : 1.0f;
+  }
+  gain_target_ = track_gain_;
+  gain_changing_tracks_ = 0;
 }
 
 void TrackManager::StateProcess(uint32_t track_number) {
+  if (quantize_count_ != 0 && IsAtQuantizeBoundary()) {
+    ApplyQuantizedEvents();
+  }
+  // The state machine follows the last applied event, not the last button pressed
+  if (quantize_subdivisions_ != 0) {
+    track_number = last_track_number_;
+  }
   current_state->Active(*this, track_number);
 }
 
+void TrackManager::StateProcess(uint32_t track_number, const float *input, float *output) {
+  ProcessFrames(track_number, input, output, SAMPLES_PER_BLOCK, true);
+}
+
+void TrackManager::ProcessFrames(uint32_t track_number, const float *input, float *output,
+                                 uint32_t nframes, bool zero_copy) {
+  uint32_t done = 0;
+  while (done < nframes) {
+    // Queued events only take effect at the start of a block
+    if (block_offset_ == 0 && quantize_count_ != 0 && IsAtQuantizeBoundary()) {
+      ApplyQuantizedEvents();
+    }
+    if (quantize_subdivisions_ != 0) {
+      track_number = last_track_number_;
+    }
+    // never cross a block boundary or the loop end within a segment
+    block_end_ = MasterBlockEnd();
+    segment_offset_ = block_offset_;
+    segment_length_ = std::min(nframes - done, block_end_ - block_offset_);
+    mixdown_performed_ = false;
+
+    if (zero_copy) {
+      io_input_ = input + done;
+      io_output_ = output + done;
+    } else {
+      std::copy(input + done, input + done + segment_length_,
+                begin(input_buffer_.samples_) + segment_offset_);
+    }
+
+    current_state->Active(*this, track_number);
+
+    float *segment_out = output + done;
+    if (!mixdown_performed_) {
+      std::fill(segment_out, segment_out + segment_length_, 0.0f);
+    } else if (!zero_copy) {
+      std::copy(begin(mixdown.samples_) + segment_offset_,
+                begin(mixdown.samples_) + segment_offset_ + segment_length_, segment_out);
+    }
+
+    done += segment_length_;
+    block_offset_ += segment_length_;
+    if (block_offset_ == block_end_) {
+      block_offset_ = 0;
+    }
+  }
+  // back to whole blocks for callers of StateProcess(track_number)
+  io_input_ = nullptr;
+  io_output_ = nullptr;
+  block_end_ = SAMPLES_PER_BLOCK;
+  segment_offset_ = 0;
+  segment_length_ = SAMPLES_PER_BLOCK;
+}
+
 // if track was set to off, ensure master indicies are update
 // if off track was longer than other, update master's end index to next
 // largest end index
 void TrackManager::UpdateMasterEndIndex() {
   uint32_t new_max = 0;
+  uint32_t new_offset = 0;
   uint16_t track = 0;
   for (auto &t : tracks) {
     if (active_group_tracks_ & (0x1 << track)) {
-      if (t.GetEndIndex() >= new_max) {
+      if (t.GetEndIndex() > new_max) {
         new_max = t.GetEndIndex();
+        new_offset = t.GetEndOffset();
+      } else if (t.GetEndIndex() == new_max && new_offset != 0 &&
+                 (t.GetEndOffset() == 0 || t.GetEndOffset() > new_offset)) {
+        // 0 is the whole block
+        new_offset = t.GetEndOffset();
       }
     }
     track++;
   }
-  std::cout << "TM:UMEI: MEI: " << master_end_index_ << ", NM: " << new_max << std::endl;
+  RT_LOG("TM:UMEI: MEI: %u, NM: %u", master_end_index_, new_max);
   master_end_index_ = new_max;
+  master_end_offset_ = new_offset;
   if (master_current_index_ > master_end_index_) {
     master_current_index_ = master_end_index_;
   }
@@ -667,6 +1119,8 @@ bool TrackManager::AreAllTracksOff(bool force_reset) {
   // reset master's indexes
   master_current_index_ = 0;
   master_end_index_ = 0;
+  master_end_offset_ = 0;
+  block_offset_ = 0;
   return true;
 }
 
@@ -704,6 +1158,11 @@ uint16_t TrackManager::GetTracksOff() {
   return off;
 }
 
+TrackState TrackManager::GetTrackState(uint32_t track_number) {
+  if (track_number >= MAX_TRACK_COUNT) { return TrackState::kOff; }
+  return tracks.at(track_number).GetTrackState();
+}
+
 // Group manaager will call upon group entering active state
 void TrackManager::SetActiveGroupTracks(uint16_t group_tracks) {
   active_group_tracks_ = group_tracks;
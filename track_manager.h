@@ -8,12 +8,30 @@
 #include "util.h"
 #include "track.h"
 #include "mixer.h"
+#include "mix_parameters.h"
 #include "track_manager_state.h"
 #include "output_i2c.h"
 
 class OutputI2C;
 class TrackManagerState;
 
+// Track events that quantized launch can hold back to a loop boundary
+enum class TrackEvent : uint8_t {
+  kDown = 0,
+  kDoubleDown,
+  kShortPulse,
+  kLongPulse
+};
+
+struct QueuedTrackEvent {
+  TrackEvent event;
+  uint8_t track;
+};
+
+#define QUANTIZE_QUEUE_SIZE 32
+// 5.3ms at 48kHz
+#define GAIN_RAMP_DEFAULT_SAMPLES 256
+
 class TrackManager {
 #ifndef DTEST_TM
   std::array<Track, MAX_TRACK_COUNT> tracks;
@@ -27,6 +45,9 @@ class TrackManager {
   // one track must start at zero (if no audio desired, don't play, record silence)
   uint32_t master_end_index_;
   uint32_t master_current_index_;
+  // Samples of the end block that are part of the loop, 0 for the whole block.
+  // The loop wraps at this sample rather than at the end of the block
+  uint32_t master_end_offset_;
   uint16_t active_group_tracks_;
   bool master_current_index_updated_;
 
@@ -34,6 +55,32 @@ class TrackManager {
   // Input for Rec and Overdub
   DataBlock input_buffer_;
 
+  // Zero-copy I/O - only set for the duration of ProcessFrames
+  // Record/Overdub read io_input_ in place of input_buffer_ and the mixdown is
+  // written to io_output_ in place of mixdown
+  const float *io_input_;
+  float *io_output_;
+  bool mixdown_performed_;
+
+  // Part of the current block being processed, the audio driver's period does not
+  // have to be SAMPLES_PER_BLOCK. Indexes are only updated once the last sample of
+  // a block has been processed. Full block unless inside ProcessFrames
+  // block_offset_ is the position on the loop's timeline within the master
+  // block, block_end_ is where that block ends, short at the loop end
+  uint32_t block_offset_;
+  uint32_t block_end_;
+  uint32_t segment_offset_;
+  uint32_t segment_length_;
+
+  // Quantized launch - with a loop playing, track events wait until the master
+  // index wraps to 0 or reaches the next 1/n of the loop. The boundary is worked
+  // out from the current master end index, which is the active group's
+  uint32_t quantize_subdivisions_;   // 0 is off
+  std::array<QueuedTrackEvent, QUANTIZE_QUEUE_SIZE> quantize_queue_;
+  uint32_t quantize_count_;
+  // Events that arrived with the queue full, dropped rather than applied early
+  uint32_t quantize_dropped_;
+
   // Output for all states
 //  DataBlock mixdown;
 
@@ -45,10 +92,71 @@ class TrackManager {
   void IndexUpdateRepeatNoChange(uint32_t track_number);
   void IndexUpdateReachedEndOfAvailableSpace(uint32_t track_number);
 #endif
+  void LastWrittenPosition(uint32_t start_index, uint32_t &index, uint32_t &offset);
 
   // Mixdown subfunctions
   uint32_t DetermineIndex(uint32_t track);
   void SilentPlaybackTrack(uint32_t track, uint32_t index);
+  void UpdateActiveTrackList();
+  uint32_t MasterBlockEnd();
+
+  void ApplyTrackEvent(TrackEvent event, uint32_t track_number);
+  bool QueueTrackEvent(TrackEvent event, uint32_t track_number);
+  bool IsAtQuantizeBoundary();
+  void ApplyQuantizedEvents();
+
+  // Tracks that may be heard (not off, not muted) - rebuilt only when a track
+  // changes state, so the mixdown cost follows the number of audible tracks
+  std::array<uint8_t, MAX_TRACK_COUNT> active_tracks_;
+  uint32_t active_track_count_;
+  uint32_t active_tracks_generation_;
+  // Block pointers of the tracks being mixed this block
+  std::array<const float*, MAX_TRACK_COUNT> mix_sources_;
+
+  // Gain and pan, nullptr mixes every track at unity. A new target is reached
+  // over ramp_samples_, carried across segments the same way as a fade in so
+  // the steps don't depend on where segments are cut. Tracks at a steady gain
+  // are mixed in one pass, tracks changing gain are added after. Fades are
+  // scaled by the track's gain
+  MixParameters *mix_parameters_;
+  MixChannel mix_channel_;
+  std::array<float, MAX_TRACK_COUNT> track_gain_;   // reached at the end of the last segment
+  std::array<float, MAX_TRACK_COUNT> mix_gains_;
+  uint16_t gain_changing_tracks_;
+  std::array<float, MAX_TRACK_COUNT> gain_target_;
+  std::array<float, MAX_TRACK_COUNT> gain_start_;
+  std::array<float, MAX_TRACK_COUNT> gain_step_;
+  std::array<uint32_t, MAX_TRACK_COUNT> gain_change_done_;   // samples into the change
+  std::array<const float*, MAX_TRACK_COUNT> change_sources_;
+  std::array<uint8_t, MAX_TRACK_COUNT> change_tracks_;
+
+  // Gain ramps - muting, unmuting and the jump of a group switch fade over
+  // ramp_samples_ rather than cut. A track fading in is mixed with a rising
+  // gain, a track fading out is mixed from its tail, its own read position on
+  // the timeline, so it carries on from where it was heard last. Nothing extra
+  // is done while no bit is set in fading_in_tracks_ or tail_tracks_
+  uint32_t ramp_samples_;             // 0 cuts
+  uint16_t audible_tracks_;           // not off or muted at the last update
+  uint16_t muted_tracks_;
+  uint16_t fading_in_tracks_;
+  uint16_t tail_tracks_;
+  std::array<uint32_t, MAX_TRACK_COUNT> fade_in_done_;   // samples into the ramp
+  std::array<uint32_t, MAX_TRACK_COUNT> tail_done_;
+  std::array<uint32_t, MAX_TRACK_COUNT> tail_position_;  // index * SAMPLES_PER_BLOCK + offset
+  std::array<const float*, MAX_TRACK_COUNT> ramp_sources_;
+  std::array<uint8_t, MAX_TRACK_COUNT> ramp_tracks_;
+  // Timeline position before the last crossfaded jump of the master index
+  bool position_jumped_;
+  uint32_t jump_position_;
+  // Dip to silence either side of the loop seam, 0 is off
+  uint32_t seam_fade_samples_;
+
+  void StartGainRamps(uint16_t audible, uint16_t muted);
+  void MixGainRamps(float *output, uint32_t ramp_count);
+  void StartGainChange(uint32_t track, float target);
+  void MixGainChanges(float *output, uint32_t change_count);
+  void MixTails(float *output);
+  void ApplySeamFade(float *output);
 
   // State Machine Section
   TrackManagerState* current_state;
@@ -83,11 +191,16 @@ class TrackManager {
 
   // For both group manager and testing
   // Group Manager deals with changing (it stores it) MasterEndIndex
-  // Whenever a group change happens
-  void SetMasterCurrentIndex(uint32_t current);
+  // Whenever a group change happens. crossfade fades tracks heard before the
+  // jump out from where they were
+  void SetMasterCurrentIndex(uint32_t current, bool crossfade = false);
   void SetMasterEndIndex(uint32_t end);
   uint32_t GetMasterCurrentIndex();
   uint32_t GetMasterEndIndex();
+  void SetMasterEndOffset(uint32_t offset);
+  uint32_t GetMasterEndOffset();
+  // Sample position within the current master block
+  uint32_t GetMasterCurrentOffset();
 
   // This is for Group Manager which knows which tracks it needs to mute/unmute
   // so no getter required, just a simple single function call to simplify code
@@ -99,6 +212,14 @@ class TrackManager {
   void SyncTrackManagerStateWithTrackState(uint32_t track_number);
   // transfer data, perform mixdown, update indexes
   void StateProcess(uint32_t track_number);
+  // Zero-copy version - input and output are the audio driver's buffers of
+  // SAMPLES_PER_BLOCK samples, output is always written (silence if no mixdown)
+  void StateProcess(uint32_t track_number, const float *input, float *output);
+  // Any number of frames - large periods are processed as several blocks, small
+  // periods as partial blocks. zero_copy records from/mixes into the buffers
+  // directly, otherwise data goes through input_buffer_ and mixdown
+  void ProcessFrames(uint32_t track_number, const float *input, float *output,
+                     uint32_t nframes, bool zero_copy = true);
 
   /*
    * TODO Organize better the state related stuff from before
@@ -159,6 +280,22 @@ class TrackManager {
   uint16_t GetTracksInMute();
   uint16_t GetTracksInPlayback();
   uint16_t GetTracksOff();
+  TrackState GetTrackState(uint32_t track_number);
   void SetActiveGroupTracks(uint16_t group_tracks);
+  // 0 applies track events straight away, 1 at the start of the loop, n at
+  // every 1/n of the loop
+  void SetQuantize(uint32_t subdivisions);
+  uint32_t GetQuantizedEventCount();
+  uint32_t GetDroppedQuantizedEvents();
+  // Length of mute/unmute and group switch fades, 0 cuts on the block edge
+  void SetGainRampLength(uint32_t samples);
+  // Fade out and in this many samples either side of the loop seam, at most
+  // SAMPLES_PER_BLOCK, 0 is off
+  void SetLoopSeamFade(uint32_t samples);
+  // Tracks with a fade in progress
+  uint16_t GetFadingTracks();
+  // Gains set from the control thread, the channel picks the pan side. Set
+  // before processing starts, nullptr is unity
+  void SetMixParameters(MixParameters *parameters, MixChannel channel = MixChannel::kMono);
 };
 #endif // TRACK_MANAGER_H
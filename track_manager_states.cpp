@@ -1,4 +1,5 @@
 #include "track_manager_states.h"
+#include "rt_log.h"
 
 /*
  * Always, any state, the mixdown is performed and data is
@@ -11,7 +12,7 @@
 // All tracks are off - system is in idle
 // State Specific Methods
 void Off::Enter(TrackManager &tm, uint32_t track_number) {
-std::cout << "Off:Enter t:" << track_number << std::endl;
+RT_LOG("Off:Enter t:%u", track_number);
   tm.SetTrackStateOff(track_number);
   tm.UpdateMasterEndIndex();
   tm.AreAllTracksOff(); // if true, it will automatically reset master indexes
@@ -31,21 +32,21 @@ void Off::Active(TrackManager &tm, uint32_t track_number) {
 
   // Event State Transitions
 void Off::DownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << ":OFF:HDE->REC" << std::endl;
+  RT_LOG("T:%u:OFF:HDE->REC", track_number);
   // OFF -> RECORD
   tm.SetState(Record::getInstance(), track_number);
 }
 
 void Off::DoubleDownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << ":OFF:DDE" << std::endl;
+  RT_LOG("T:%u:OFF:DDE", track_number);
 }
 
 void Off::ShortPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << ":OFF:SPE" << std::endl;
+  RT_LOG("T:%u:OFF:SPE", track_number);
 }
 
 void Off::LongPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "OFF:LPE" << std::endl;
+  RT_LOG("T:%uOFF:LPE", track_number);
 }
 
 Off& Off::getInstance() {
@@ -86,21 +87,21 @@ void Record::Active(TrackManager &tm, uint32_t track_number) {
 
   // Event State Transitions
 void Record::DownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << ":RECORD:HDE->PLY" << std::endl;
+  RT_LOG("T:%u:RECORD:HDE->PLY", track_number);
   // RECORD -> PLAY
   tm.SetState(Play::getInstance(), track_number);
 }
 
 void Record::DoubleDownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number <<  "RECORD:DDE" << std::endl;
+  RT_LOG("T:%uRECORD:DDE", track_number);
 }
 
 void Record::ShortPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "RECORD:SPE" << std::endl;
+  RT_LOG("T:%uRECORD:SPE", track_number);
 }
 
 void Record::LongPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "RECORD:LPE->RPT" << std::endl;
+  RT_LOG("T:%uRECORD:LPE->RPT", track_number);
   // RECORD -> REPEAT
   tm.SetState(Repeat::getInstance(), track_number);
 }
@@ -136,22 +137,22 @@ void Overdub::Active(TrackManager &tm, uint32_t track_number) {
 
   // Event State Transitions
 void Overdub::DownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "OVERDUB:HDE->PLY" << std::endl;
+  RT_LOG("T:%uOVERDUB:HDE->PLY", track_number);
   // OVERDUB -> PLAY
   tm.SetState(Play::getInstance(), track_number);
 }
 
 void Overdub::DoubleDownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "OVERDUB:DDE->MUT" << std::endl;
+  RT_LOG("T:%uOVERDUB:DDE->MUT", track_number);
   tm.SetState(Mute::getInstance(), track_number);
 }
 
 void Overdub::ShortPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "OVERDUB:SPE" << std::endl;
+  RT_LOG("T:%uOVERDUB:SPE", track_number);
 }
 
 void Overdub::LongPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "OVERDUB:LPE->RPT" << std::endl;
+  RT_LOG("T:%uOVERDUB:LPE->RPT", track_number);
   // OVERDUB -> REPEAT
   tm.SetState(Repeat::getInstance(), track_number);
 }
@@ -181,22 +182,22 @@ void Play::Active(TrackManager &tm, uint32_t track_number) {
 
   // Event State Transitions
 void Play::DownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "PLAY:HDE->OVD" << std::endl;
+  RT_LOG("T:%uPLAY:HDE->OVD", track_number);
   // PLAY -> OVERDUB
   tm.SetState(Overdub::getInstance(), track_number);
 }
 
 void Play::DoubleDownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "PLAY:DDE->OFF" << std::endl;
+  RT_LOG("T:%uPLAY:DDE->OFF", track_number);
   tm.SetState(Off::getInstance(), track_number);
 }
 
 void Play::ShortPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "PLAY:SPE" << std::endl;
+  RT_LOG("T:%uPLAY:SPE", track_number);
 }
 
 void Play::LongPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "PLAY:LPE" << std::endl;
+  RT_LOG("T:%uPLAY:LPE", track_number);
 }
 
 Play& Play::getInstance() {
@@ -224,21 +225,21 @@ void Repeat::Active(TrackManager &tm, uint32_t track_number) {
 
   // Event State Transitions
 void Repeat::DownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "REPEAT:HDE->MUT" << std::endl;
+  RT_LOG("T:%uREPEAT:HDE->MUT", track_number);
   // REPEAT -> MUTE
   tm.SetState(Mute::getInstance(), track_number);
 }
 
 void Repeat::DoubleDownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "REPEAT:DDE" << std::endl;
+  RT_LOG("T:%uREPEAT:DDE", track_number);
 }
 
 void Repeat::ShortPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "REPEAT:SPE" << std::endl;
+  RT_LOG("T:%uREPEAT:SPE", track_number);
 }
 
 void Repeat::LongPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "REPEAT:LPE" << std::endl;
+  RT_LOG("T:%uREPEAT:LPE", track_number);
 }
 
 Repeat& Repeat::getInstance() {
@@ -264,22 +265,22 @@ void Mute::Active(TrackManager &tm, uint32_t track_number) {
 
   // Event State Transitions
 void Mute::DownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "MUTE:HDE->PLY" << std::endl;
+  RT_LOG("T:%uMUTE:HDE->PLY", track_number);
   // MUTE -> PLAY
   tm.SetState(Play::getInstance(), track_number);
 }
 
 void Mute::DoubleDownEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "MUTE:DDE->OFF" << std::endl;
+  RT_LOG("T:%uMUTE:DDE->OFF", track_number);
   tm.SetState(Off::getInstance(), track_number);
 }
 
 void Mute::ShortPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "MUTE:SPE" << std::endl;
+  RT_LOG("T:%uMUTE:SPE", track_number);
 }
 
 void Mute::LongPulseEvent(TrackManager &tm, uint32_t track_number) {
-  std::cout << "T:" << track_number << "MUTE:LPE->RPT" << std::endl;
+  RT_LOG("T:%uMUTE:LPE->RPT", track_number);
   tm.SetState(Repeat::getInstance(), track_number);
 }
 
@@ -6,5 +6,15 @@
 #define MAX_BLOCK_COUNT 47000
 #define MAX_TRACK_COUNT 16
 
+// Track storage is paged, a page is a run of consecutive blocks taken from the
+// BlockPool when first written
+#define BLOCKS_PER_PAGE 32
+#define PAGES_PER_TRACK ((MAX_BLOCK_COUNT + BLOCKS_PER_PAGE - 1) / BLOCKS_PER_PAGE)
+// Shared by every track of every TrackManager, 16KB per page
+// 8192 pages is 128MB or about 13 minutes of mono audio
+#ifndef BLOCK_POOL_PAGE_COUNT
+#define BLOCK_POOL_PAGE_COUNT 8192
+#endif
+
 
 #endif // UTIL_H
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string.h>
+#include "wav_file.h"
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+// WAV is little endian, as are the Pi and x86
+static uint32_t ReadLe(const uint8_t *bytes, uint32_t count) {
+  uint32_t value = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    value |= (uint32_t)bytes[i] << (8 * i);
+  }
+  return value;
+}
+
+static void WriteLe(std::ofstream &file, uint32_t value, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    file.put((char)((value >> (8 * i)) & 0xFF));
+  }
+}
+
+bool ReadWav(const char *path, std::vector<float> &samples, uint32_t &sample_rate) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::cerr << "error: can't open " << path << std::endl;
+    return false;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if (data.size() < 12 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0) {
+    std::cerr << "error: " << path << " is not a WAV file" << std::endl;
+    return false;
+  }
+
+  uint32_t format = 0;
+  uint32_t channels = 0;
+  uint32_t bits = 0;
+  const uint8_t *sample_data = nullptr;
+  uint32_t sample_bytes = 0;
+  // Chunks are word aligned
+  for (size_t pos = 12; pos + 8 <= data.size();) {
+    uint32_t size = ReadLe(&data[pos + 4], 4);
+    const uint8_t *chunk = &data[pos + 8];
+    size = std::min<size_t>(size, data.size() - pos - 8);
+    if (memcmp(&data[pos], "fmt ", 4) == 0 && size >= 16) {
+      format = ReadLe(chunk, 2);
+      channels = ReadLe(chunk + 2, 2);
+      sample_rate = ReadLe(chunk + 4, 4);
+      bits = ReadLe(chunk + 14, 2);
+      if (format == WAV_FORMAT_EXTENSIBLE && size >= 26) {
+        format = ReadLe(chunk + 24, 2);
+      }
+    } else if (memcmp(&data[pos], "data", 4) == 0) {
+      sample_data = chunk;
+      sample_bytes = size;
+    }
+    pos += 8 + size + (size & 0x1);
+  }
+
+  bool supported = (format == WAV_FORMAT_PCM && (bits == 16 || bits == 24)) ||
+                   (format == WAV_FORMAT_FLOAT && bits == 32);
+  if (sample_data == nullptr || channels == 0 || !supported) {
+    std::cerr << "error: " << path << " format " << format << ", " << bits
+              << " bits not supported" << std::endl;
+    return false;
+  }
+
+  uint32_t bytes_per_sample = bits / 8;
+  uint32_t frame_bytes = bytes_per_sample * channels;
+  uint32_t frames = sample_bytes / frame_bytes;
+  samples.resize(frames);
+  for (uint32_t f = 0; f < frames; f++) {
+    const uint8_t *sample = sample_data + f * frame_bytes;
+    if (format == WAV_FORMAT_FLOAT) {
+      uint32_t raw = ReadLe(sample, 4);
+      memcpy(&samples[f], &raw, sizeof(float));
+    } else if (bits == 16) {
+      samples[f] = (int16_t)ReadLe(sample, 2) / 32768.0f;
+    } else {
+      // sign extend 24 bits
+      samples[f] = ((int32_t)(ReadLe(sample, 3) << 8) >> 8) / 8388608.0f;
+    }
+  }
+  return true;
+}
+
+bool WriteWav(const char *path, const std::vector<std::vector<float>> &channels, uint32_t sample_rate) {
+  if (channels.empty()) { return false; }
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    std::cerr << "error: can't create " << path << std::endl;
+    return false;
+  }
+  uint32_t channel_count = channels.size();
+  uint32_t frames = channels[0].size();
+  uint32_t data_bytes = frames * channel_count * sizeof(float);
+
+  file.write("RIFF", 4);
+  WriteLe(file, 36 + data_bytes, 4);
+  file.write("WAVE", 4);
+  file.write("fmt ", 4);
+  WriteLe(file, 16, 4);
+  WriteLe(file, WAV_FORMAT_FLOAT, 2);
+  WriteLe(file, channel_count, 2);
+  WriteLe(file, sample_rate, 4);
+  WriteLe(file, sample_rate * channel_count * sizeof(float), 4);
+  WriteLe(file, channel_count * sizeof(float), 2);
+  WriteLe(file, 32, 2);
+  file.write("data", 4);
+  WriteLe(file, data_bytes, 4);
+  for (uint32_t f = 0; f < frames; f++) {
+    for (uint32_t c = 0; c < channel_count; c++) {
+      float sample = f < channels[c].size() ? channels[c][f] : 0.0f;
+      uint32_t raw;
+      memcpy(&raw, &sample, sizeof(float));
+      WriteLe(file, raw, 4);
+    }
+  }
+  return (bool)file;
+}
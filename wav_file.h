@@ -0,0 +1,13 @@
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+#include <stdint.h>
+#include <vector>
+
+// Minimal RIFF WAVE reader and writer for the offline tools. Reads 16 and 24
+// bit PCM and 32 bit float, keeping only the first channel as the engine is
+// mono per TrackManager. Writes 32 bit float, one channel per vector
+bool ReadWav(const char *path, std::vector<float> &samples, uint32_t &sample_rate);
+bool WriteWav(const char *path, const std::vector<std::vector<float>> &channels, uint32_t sample_rate);
+
+#endif // WAV_FILE_H